@@ -0,0 +1,152 @@
+#include "AdaptiveSlicer.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Levels closer than this (of 255) are the same, a window whose on and off are any closer is only noise
+constexpr double MIN_SWING = 2;
+// Histogram bins per level for Otsu, the swing of a dim LED is only a few levels
+constexpr int BINS_PER_LEVEL = 4;
+constexpr int HISTOGRAM_BINS = 256 * BINS_PER_LEVEL;
+
+std::optional<AdaptiveSlicer::Kind> AdaptiveSlicer::parse(const std::string &name) {
+    if (name == "midpoint") {
+        return Kind::MIDPOINT;
+    } else if (name == "ewma") {
+        return Kind::EWMA;
+    } else if (name == "otsu") {
+        return Kind::OTSU;
+    }
+    return std::nullopt;
+}
+
+AdaptiveSlicer::AdaptiveSlicer(Kind kind, size_t window) : m_kind(kind), m_window(std::max<size_t>(window, 2)) {
+    // The EWMA's weights add up to the same span as a window of m_window frames
+    m_alpha = 2.0 / (m_window + 1);
+    if (m_kind == Kind::OTSU) {
+        m_histogram.assign(HISTOGRAM_BINS, 0);
+    }
+}
+
+std::optional<int> AdaptiveSlicer::slice(double level) {
+    std::optional<double> threshold;
+    switch (m_kind) {
+        case Kind::MIDPOINT:
+            threshold = midpointThreshold(level);
+            break;
+        case Kind::EWMA:
+            threshold = ewmaThreshold(level);
+            break;
+        case Kind::OTSU:
+            threshold = otsuThreshold(level);
+            break;
+    }
+    ++m_frame;
+
+    if (!threshold.has_value() || level == threshold.value()) {
+        return std::nullopt;
+    }
+    return level > threshold.value() ? 1 : 0;
+}
+
+void AdaptiveSlicer::trackExtremes(double value) {
+    // Monotonic queues, a value is dropped once a newer one is at least as low (or high), so each is pushed and
+    // popped once and the window's minimum and maximum are always at the front
+    while (!m_lows.empty() && m_lows.back().second >= value) {
+        m_lows.pop_back();
+    }
+    while (!m_highs.empty() && m_highs.back().second <= value) {
+        m_highs.pop_back();
+    }
+    m_lows.emplace_back(m_frame, value);
+    m_highs.emplace_back(m_frame, value);
+    while (m_lows.front().first + m_window <= m_frame) {
+        m_lows.pop_front();
+    }
+    while (m_highs.front().first + m_window <= m_frame) {
+        m_highs.pop_front();
+    }
+}
+
+std::optional<double> AdaptiveSlicer::midpointThreshold(double level) {
+    trackExtremes(level);
+
+    const double low = m_lows.front().second;
+    const double high = m_highs.front().second;
+    if (high - low < MIN_SWING) {
+        return std::nullopt;
+    }
+    return (low + high) / 2;
+}
+
+std::optional<double> AdaptiveSlicer::ewmaThreshold(double level) {
+    if (!m_clusters.has_value()) {
+        m_clusters = std::make_pair(level, level);
+    }
+    double &off = m_clusters->first;
+    double &on = m_clusters->second;
+
+    // The frame is sliced on the clusters before it moves them, ties go to off until the two have split
+    const double threshold = (on + off) / 2;
+    const bool separated = on - off >= MIN_SWING;
+    // A plain average until a cluster has seen a window of frames, so the first ones settle sooner
+    if (level > threshold) {
+        on += std::max(m_alpha, 1.0 / ++m_onFrames) * (level - on);
+    } else {
+        off += std::max(m_alpha, 1.0 / ++m_offFrames) * (level - off);
+    }
+
+    if (!separated) {
+        return std::nullopt;
+    }
+    return threshold;
+}
+
+std::optional<double> AdaptiveSlicer::otsuThreshold(double level) {
+    const int bin = std::clamp((int) std::lround(level * BINS_PER_LEVEL), 0, HISTOGRAM_BINS - 1);
+    m_bins.push_back(bin);
+    ++m_histogram[bin];
+    m_binSum += bin;
+    if (m_bins.size() > m_window) {
+        --m_histogram[m_bins.front()];
+        m_binSum -= m_bins.front();
+        m_bins.pop_front();
+    }
+    trackExtremes(bin);
+
+    // Otsu's method over the bins the window's levels span, outside them one of the classes is empty. The work is
+    // the LED's swing in bins, not the whole histogram
+    const int lowest = (int) m_lows.front().second;
+    const int highest = (int) m_highs.front().second;
+    const double total = m_bins.size();
+    const double sum = m_binSum;
+
+    double below = 0, belowSum = 0;
+    double bestVariance = -1;
+    int bestBin = 0;
+    double lowMean = 0, highMean = 0;
+    for (int b = lowest; b < highest; ++b) {
+        below += m_histogram[b];
+        belowSum += (double) b * m_histogram[b];
+        const double above = total - below;
+        if (below == 0 || above == 0) {
+            continue;
+        }
+
+        const double low = belowSum / below;
+        const double high = (sum - belowSum) / above;
+        const double variance = below * above * (high - low) * (high - low);
+        if (variance > bestVariance) {
+            bestVariance = variance;
+            bestBin = b;
+            lowMean = low;
+            highMean = high;
+        }
+    }
+
+    if (bestVariance < 0 || (highMean - lowMean) / BINS_PER_LEVEL < MIN_SWING) {
+        return std::nullopt;
+    }
+    // Everything in bestBin or below is off
+    return (bestBin + 0.5) / BINS_PER_LEVEL;
+}
@@ -0,0 +1,66 @@
+#ifndef ANALYSIS_TOOL_ADAPTIVESLICER_H
+#define ANALYSIS_TOOL_ADAPTIVESLICER_H
+
+#pragma once
+#include <deque>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Decides one ROI's bits from its levels alone, frame by frame and without ground truth (--slicer)
+ * The threshold follows the levels of the last window frames, so a slow drift of the lighting over a run moves it
+ * along instead of turning in to a burst of errors. The midpoint and EWMA take constant time per frame whatever the
+ * window, Otsu's time goes with the spread of the window's levels.
+ */
+class AdaptiveSlicer {
+public:
+    enum class Kind {
+        // Halfway between the lowest and highest level in the window
+        MIDPOINT,
+        // Halfway between running averages of the on and the off frames, each frame moves the cluster it joins
+        EWMA,
+        // Otsu's threshold of the window's histogram of levels
+        OTSU
+    };
+
+    static std::optional<Kind> parse(const std::string &name);
+
+    AdaptiveSlicer(Kind kind, size_t window);
+
+    // The bit of the next frame's level, nullopt until the window has seen both an on and an off level
+    std::optional<int> slice(double level);
+
+private:
+    // Slides the window of m_lows and m_highs on by a frame
+    void trackExtremes(double value);
+
+    std::optional<double> midpointThreshold(double level);
+
+    std::optional<double> ewmaThreshold(double level);
+
+    std::optional<double> otsuThreshold(double level);
+
+    Kind m_kind;
+    size_t m_window;
+    size_t m_frame = 0;
+
+    // Sliding window minimum and maximum, the frame number and level (histogram bin for Otsu) of every candidate
+    // still in the window
+    std::deque<std::pair<size_t, double>> m_lows;
+    std::deque<std::pair<size_t, double>> m_highs;
+
+    // The on and off clusters' means, the first level starts both
+    std::optional<std::pair<double, double>> m_clusters;
+    double m_alpha;
+    size_t m_onFrames = 0;
+    size_t m_offFrames = 0;
+
+    // The window's levels as histogram bins, oldest first, the histogram and the sum of the bins
+    std::deque<int> m_bins;
+    std::vector<size_t> m_histogram;
+    long m_binSum = 0;
+};
+
+#endif //ANALYSIS_TOOL_ADAPTIVESLICER_H
@@ -0,0 +1,68 @@
+#ifndef ANALYSIS_TOOL_BOUNDEDQUEUE_H
+#define ANALYSIS_TOOL_BOUNDEDQUEUE_H
+
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+/*
+ * Blocking multi producer, multi consumer queue between the stages of the frame pipeline
+ * push waits while the queue is full, so a stage that runs ahead can only get capacity items ahead of the next
+ * one instead of holding the whole video in memory. Once closed, pop drains what is left and then returns nullopt.
+ */
+template<typename T>
+class BoundedQueue {
+private:
+    const size_t m_capacity;
+    std::deque<T> m_items;
+    bool m_closed = false;
+    std::mutex m_lock;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity(capacity) {}
+
+    // Returns false (and drops the item) if the queue was closed
+    bool push(T item) {
+        std::unique_lock<std::mutex> guard(m_lock);
+        m_notFull.wait(guard, [this]() { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed) {
+            return false;
+        }
+
+        m_items.push_back(std::move(item));
+        guard.unlock();
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> guard(m_lock);
+        m_notEmpty.wait(guard, [this]() { return m_closed || !m_items.empty(); });
+        if (m_items.empty()) {
+            return std::nullopt;
+        }
+
+        T item = std::move(m_items.front());
+        m_items.pop_front();
+        guard.unlock();
+        m_notFull.notify_one();
+        return item;
+    }
+
+    // No more items are coming, wakes everyone waiting
+    void close() {
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_closed = true;
+        }
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+};
+
+#endif //ANALYSIS_TOOL_BOUNDEDQUEUE_H
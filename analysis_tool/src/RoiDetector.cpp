@@ -0,0 +1,106 @@
+#include "RoiDetector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Width the frames are shrunk to, an LED a few pixels across in a 1280 wide frame is still one pixel at 160
+constexpr int DETECTION_WIDTH = 160;
+// Pixels varying at least this fraction of the strongest one belong to the LED
+constexpr double VARIANCE_FRACTION = 0.25;
+// Below this (grey levels squared) the strongest pixel is only sensor noise and nothing blinked
+constexpr double MIN_VARIANCE = 4;
+
+RoiDetector::RoiDetector(int frames) : m_frames(frames), m_count(0), m_scale(1) {}
+
+bool RoiDetector::add(const cv::Mat &frame) {
+    if (m_count == 0) {
+        m_frameSize = frame.size();
+        m_scale = std::min(1.0, (double) DETECTION_WIDTH / frame.cols);
+    }
+
+    cv::resize(frame, m_small, cv::Size(), m_scale, m_scale, cv::INTER_AREA);
+    if (m_small.channels() == 3) {
+        cv::cvtColor(m_small, m_grey, cv::COLOR_BGR2GRAY);
+    } else {
+        m_grey = m_small;
+    }
+
+    if (m_count == 0) {
+        m_sum = cv::Mat::zeros(m_grey.size(), CV_64FC1);
+        m_sumSquares = cv::Mat::zeros(m_grey.size(), CV_64FC1);
+    }
+    cv::accumulate(m_grey, m_sum);
+    cv::accumulateSquare(m_grey, m_sumSquares);
+
+    return ++m_count < m_frames;
+}
+
+std::optional<cv::Rect> RoiDetector::result() const {
+    if (m_count < 2) {
+        return std::nullopt;
+    }
+
+    // Var = E[x^2] - E[x]^2, the image is small enough for this to be done once without any care
+    cv::Mat variance(m_sum.size(), CV_64FC1);
+    double maxVariance = 0;
+    cv::Point strongest;
+    for (int y = 0; y < variance.rows; ++y) {
+        const double *sum = m_sum.ptr<double>(y);
+        const double *sumSquares = m_sumSquares.ptr<double>(y);
+        double *row = variance.ptr<double>(y);
+        for (int x = 0; x < variance.cols; ++x) {
+            const double mean = sum[x] / m_count;
+            row[x] = sumSquares[x] / m_count - mean * mean;
+            if (row[x] > maxVariance) {
+                maxVariance = row[x];
+                strongest = cv::Point(x, y);
+            }
+        }
+    }
+
+    if (maxVariance < MIN_VARIANCE) {
+        return std::nullopt;
+    }
+
+    cv::Mat mask(variance.size(), CV_8UC1);
+    for (int y = 0; y < variance.rows; ++y) {
+        const double *row = variance.ptr<double>(y);
+        auto *masked = mask.ptr<uchar>(y);
+        for (int x = 0; x < variance.cols; ++x) {
+            masked[x] = row[x] >= VARIANCE_FRACTION * maxVariance ? 255 : 0;
+        }
+    }
+
+    // Reflections of the LED vary as well, only the blob around the strongest pixel is kept
+    cv::Mat labels, stats, centroids;
+    cv::connectedComponentsWithStats(mask, labels, stats, centroids, 8, CV_32S);
+    const int label = labels.at<int>(strongest.y, strongest.x);
+
+    const int left = stats.at<int>(label, cv::CC_STAT_LEFT);
+    const int top = stats.at<int>(label, cv::CC_STAT_TOP);
+    const int right = left + stats.at<int>(label, cv::CC_STAT_WIDTH);
+    const int bottom = top + stats.at<int>(label, cv::CC_STAT_HEIGHT);
+
+    const int x = (int) std::floor(left / m_scale);
+    const int y = (int) std::floor(top / m_scale);
+    const int width = std::min((int) std::ceil(right / m_scale), m_frameSize.width) - x;
+    const int height = std::min((int) std::ceil(bottom / m_scale), m_frameSize.height) - y;
+
+    return cv::Rect(x, y, width, height);
+}
+
+std::optional<cv::Rect> RoiDetector::detect(const std::string &video, int frames) {
+    cv::VideoCapture capture(video);
+    if (!capture.isOpened()) {
+        std::cout << "Cannot open the video file: " << video << std::endl;
+        return std::nullopt;
+    }
+
+    RoiDetector detector(frames);
+    cv::Mat frame;
+    while (capture.read(frame) && detector.add(frame)) {}
+    capture.release();
+
+    return detector.result();
+}
@@ -0,0 +1,42 @@
+#ifndef ANALYSIS_TOOL_ROIDETECTOR_H
+#define ANALYSIS_TOOL_ROIDETECTOR_H
+
+#pragma once
+#include <optional>
+#include <string>
+#include <opencv2/opencv.hpp>
+
+/*
+ * Finds the blinking LED without anyone pointing at it
+ * Every frame is shrunk to DETECTION_WIDTH pixels across and its grey levels are accumulated along with their squares
+ * (cv::accumulate/accumulateSquare, both vectorised), which gives each pixel's variance over time. The LED is the
+ * pixel that varies the most, its ROI is the bounding box of the connected pixels varying at least
+ * VARIANCE_FRACTION as much, scaled back up to the full frame.
+ * Ambient light and the water only drift slowly, an on-off keyed LED swings between its two levels every few frames.
+ */
+class RoiDetector {
+private:
+    const int m_frames;
+    int m_count;
+    double m_scale;
+    cv::Size m_frameSize;
+
+    cv::Mat m_small;
+    cv::Mat m_grey;
+    cv::Mat m_sum;
+    cv::Mat m_sumSquares;
+
+public:
+    explicit RoiDetector(int frames);
+
+    // Adds the frame to the statistics, false once enough frames were seen
+    bool add(const cv::Mat &frame);
+
+    // The LED's ROI in full resolution pixels, nullopt if nothing blinked
+    std::optional<cv::Rect> result() const;
+
+    // Runs over the first frames of the video
+    static std::optional<cv::Rect> detect(const std::string &video, int frames);
+};
+
+#endif //ANALYSIS_TOOL_ROIDETECTOR_H
@@ -0,0 +1,139 @@
+#include "RoiKernel.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(__AVX2__)
+constexpr size_t BLOCK_BYTES = 96;
+#else
+constexpr size_t BLOCK_BYTES = 48;
+#endif
+
+std::optional<ChannelMix> ChannelMix::parse(const std::string &spec) {
+    ChannelMix mix;
+    if (spec == "blue") {
+        mix = ChannelMix{{1, 0, 0}};
+    } else if (spec == "green") {
+        mix = ChannelMix{{0, 1, 0}};
+    } else if (spec == "red") {
+        mix = ChannelMix{{0, 0, 1}};
+    } else if (spec == "grey" || spec == "gray") {
+        mix = ChannelMix{{0.114, 0.587, 0.299}};
+    } else {
+        char trailing;
+        if (sscanf(spec.c_str(), "%lf,%lf,%lf %c", &mix.weights[0], &mix.weights[1], &mix.weights[2],
+                   &trailing) != 3) {
+            return std::nullopt;
+        }
+    }
+
+    if (mix.weights[0] == 0 && mix.weights[1] == 0 && mix.weights[2] == 0) {
+        return std::nullopt;
+    }
+    return mix;
+}
+
+double ChannelMix::apply(const cv::Scalar &means) const {
+    return weights[0] * means[0] + weights[1] * means[1] + weights[2] * means[2];
+}
+
+uint64_t sumChannel(const uint8_t *data, size_t step, int width, int height, int channels, int channel) {
+    const size_t rowBytes = (size_t) width * channels;
+    const size_t blockEnd = rowBytes - rowBytes % BLOCK_BYTES;
+
+    // 0xFF on the channel's bytes, BLOCK_BYTES is a multiple of the pixel size so one pattern fits every block
+    alignas(32) uint8_t pattern[BLOCK_BYTES];
+    for (size_t b = 0; b < BLOCK_BYTES; ++b) {
+        pattern[b] = b % channels == (size_t) channel ? 0xFF : 0;
+    }
+
+    uint64_t total = 0;
+
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i mask0 = _mm256_load_si256((const __m256i *) pattern);
+    const __m256i mask1 = _mm256_load_si256((const __m256i *) (pattern + 32));
+    const __m256i mask2 = _mm256_load_si256((const __m256i *) (pattern + 64));
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mask0 = _mm_load_si128((const __m128i *) pattern);
+    const __m128i mask1 = _mm_load_si128((const __m128i *) (pattern + 16));
+    const __m128i mask2 = _mm_load_si128((const __m128i *) (pattern + 32));
+#elif defined(__ARM_NEON)
+    const uint8x16_t mask0 = vld1q_u8(pattern);
+    const uint8x16_t mask1 = vld1q_u8(pattern + 16);
+    const uint8x16_t mask2 = vld1q_u8(pattern + 32);
+#endif
+
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *row = data + y * step;
+        size_t i = 0;
+
+#if defined(__AVX2__)
+        __m256i sums = zero;
+        for (; i < blockEnd; i += BLOCK_BYTES) {
+            const __m256i v0 = _mm256_and_si256(_mm256_loadu_si256((const __m256i *) (row + i)), mask0);
+            const __m256i v1 = _mm256_and_si256(_mm256_loadu_si256((const __m256i *) (row + i + 32)), mask1);
+            const __m256i v2 = _mm256_and_si256(_mm256_loadu_si256((const __m256i *) (row + i + 64)), mask2);
+            sums = _mm256_add_epi64(sums, _mm256_sad_epu8(v0, zero));
+            sums = _mm256_add_epi64(sums, _mm256_sad_epu8(v1, zero));
+            sums = _mm256_add_epi64(sums, _mm256_sad_epu8(v2, zero));
+        }
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256((__m256i *) lanes, sums);
+        total += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__SSE2__)
+        __m128i sums = zero;
+        for (; i < blockEnd; i += BLOCK_BYTES) {
+            const __m128i v0 = _mm_and_si128(_mm_loadu_si128((const __m128i *) (row + i)), mask0);
+            const __m128i v1 = _mm_and_si128(_mm_loadu_si128((const __m128i *) (row + i + 16)), mask1);
+            const __m128i v2 = _mm_and_si128(_mm_loadu_si128((const __m128i *) (row + i + 32)), mask2);
+            sums = _mm_add_epi64(sums, _mm_sad_epu8(v0, zero));
+            sums = _mm_add_epi64(sums, _mm_sad_epu8(v1, zero));
+            sums = _mm_add_epi64(sums, _mm_sad_epu8(v2, zero));
+        }
+        alignas(16) uint64_t lanes[2];
+        _mm_store_si128((__m128i *) lanes, sums);
+        total += lanes[0] + lanes[1];
+#elif defined(__ARM_NEON)
+        // Each step adds at most 4 * 255 to a lane, a row would have to be millions of pixels wide to overflow
+        uint32x4_t sums = vdupq_n_u32(0);
+        for (; i < blockEnd; i += BLOCK_BYTES) {
+            sums = vpadalq_u16(sums, vpaddlq_u8(vandq_u8(vld1q_u8(row + i), mask0)));
+            sums = vpadalq_u16(sums, vpaddlq_u8(vandq_u8(vld1q_u8(row + i + 16), mask1)));
+            sums = vpadalq_u16(sums, vpaddlq_u8(vandq_u8(vld1q_u8(row + i + 32), mask2)));
+        }
+        const uint64x2_t lanes = vpaddlq_u32(sums);
+        total += vgetq_lane_u64(lanes, 0) + vgetq_lane_u64(lanes, 1);
+#endif
+
+        for (i += channel; i < rowBytes; i += channels) {
+            total += row[i];
+        }
+    }
+
+    return total;
+}
+
+cv::Scalar mixedMeans(const cv::Mat &roi, const ChannelMix &mix) {
+    CV_Assert(roi.depth() == CV_8U);
+    cv::Scalar means;
+    const double area = (double) roi.rows * roi.cols;
+    if (area == 0) {
+        return means;
+    }
+
+    const int channels = roi.channels();
+    for (int c = 0; c < std::min(channels, 3); ++c) {
+        if (mix.weights[c] != 0) {
+            means[c] = sumChannel(roi.ptr<uint8_t>(0), roi.step, roi.cols, roi.rows, channels, c) / area;
+        }
+    }
+    return means;
+}
@@ -0,0 +1,37 @@
+#ifndef ANALYSIS_TOOL_ROIKERNEL_H
+#define ANALYSIS_TOOL_ROIKERNEL_H
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <opencv2/opencv.hpp>
+
+/*
+ * Which mix of the colour channels the bits are sliced on (--channel), in OpenCV's BGR order
+ * The default is blue alone, which is what the threshold has always looked at.
+ */
+struct ChannelMix {
+    double weights[3]{1, 0, 0};
+
+    // blue, green, red, grey (BT.601 luma) or three comma separated weights for b,g,r
+    static std::optional<ChannelMix> parse(const std::string &spec);
+
+    // The mixed level of per-channel means
+    double apply(const cv::Scalar &means) const;
+};
+
+/*
+ * Sum of one channel of an 8-bit interleaved image, row by row over the (possibly strided) rows
+ * The channel is picked out with a repeating byte mask and summed with SAD against zero (SSE2/AVX2) or pairwise
+ * widening adds (NEON), so the accumulators are integers and never overflow. 48 bytes (96 with AVX2) are handled per
+ * step, a whole number of pixels for 1, 3 and 4 channels, so only the last few pixels of a row go through the scalar
+ * loop.
+ */
+uint64_t sumChannel(const uint8_t *data, size_t step, int width, int height, int channels, int channel);
+
+// Means of the channels the mix uses, the others (and any the 8-bit roi doesn't have) are left at 0, as cv::mean would
+cv::Scalar mixedMeans(const cv::Mat &roi, const ChannelMix &mix);
+
+#endif //ANALYSIS_TOOL_ROIKERNEL_H
@@ -0,0 +1,113 @@
+#include "RoiTable.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#if __has_include(<filesystem>)
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+std::optional<cv::Rect> RoiTable::parseRect(const std::string &text) {
+    int x, y, width, height;
+    char trailing;
+    if (sscanf(text.c_str(), "%d,%d,%d,%d %c", &x, &y, &width, &height, &trailing) != 4) {
+        return std::nullopt;
+    }
+    if (x < 0 || y < 0 || width <= 0 || height <= 0) {
+        return std::nullopt;
+    }
+    return cv::Rect(x, y, width, height);
+}
+
+bool RoiTable::load(const std::string &path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cout << "Unable to open the ROI file: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (getline(file, line)) {
+        ++lineNumber;
+        std::istringstream entry(line);
+        std::string name, rect;
+        if (!(entry >> name) || name[0] == '#') {
+            continue;
+        }
+
+        std::vector<cv::Rect> rois;
+        while (entry >> rect) {
+            auto roi = parseRect(rect);
+            if (!roi.has_value()) {
+                rois.clear();
+                break;
+            }
+            rois.push_back(roi.value());
+        }
+        if (rois.empty()) {
+            std::cout << path << ":" << lineNumber << ": expected <file name> x,y,w,h [x,y,w,h ...], got: " << line
+                      << std::endl;
+            return false;
+        }
+
+        if (name == "*") {
+            m_default = rois;
+        } else {
+            m_rois[name] = rois;
+        }
+    }
+
+    return true;
+}
+
+void RoiTable::setDefault(const std::vector<cv::Rect> &rois) {
+    m_default = rois;
+}
+
+void RoiTable::set(const std::string &video, const std::vector<cv::Rect> &rois) {
+    m_rois[fs::path(video).filename().string()] = rois;
+}
+
+bool RoiTable::save(const std::string &path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cout << "Unable to write the ROI file: " << path << std::endl;
+        return false;
+    }
+
+    auto writeEntry = [&file](const std::string &name, const std::vector<cv::Rect> &rois) {
+        file << name;
+        for (const cv::Rect &roi : rois) {
+            file << " " << roi.x << "," << roi.y << "," << roi.width << "," << roi.height;
+        }
+        file << "\n";
+    };
+
+    if (!m_default.empty()) {
+        writeEntry("*", m_default);
+    }
+    for (const auto &entry : m_rois) {
+        writeEntry(entry.first, entry.second);
+    }
+
+    return file.good();
+}
+
+std::vector<cv::Rect> RoiTable::find(const std::string &video) const {
+    auto roi = m_rois.find(fs::path(video).filename().string());
+    if (roi != m_rois.end()) {
+        return roi->second;
+    }
+    return m_default;
+}
+
+bool RoiTable::empty() const {
+    return m_default.empty() && m_rois.empty();
+}
@@ -0,0 +1,47 @@
+#ifndef ANALYSIS_TOOL_ROITABLE_H
+#define ANALYSIS_TOOL_ROITABLE_H
+
+#pragma once
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+/*
+ * Regions of interest handed over up front so a run never has to stop for cv::selectROI
+ * The ROI file has one entry per line, a video's file name (or * for every other video) followed by one x,y,w,h for
+ * each LED, in the order their columns appear in the CSV:
+ *  # LED position for the whole dataset
+ *  *                   412,310,24,24
+ *  on_100fps_20c.avi   405,302,30,30
+ *  two_leds.avi        412,310,24,24 1692,310,24,24
+ * Blank lines and lines starting with # are ignored.
+ */
+class RoiTable {
+private:
+    std::vector<cv::Rect> m_default;
+    std::map<std::string, std::vector<cv::Rect>> m_rois;
+
+public:
+    // Parses "x,y,w,h", nullopt if it isn't one or the rectangle is empty
+    static std::optional<cv::Rect> parseRect(const std::string &text);
+
+    // Adds the entries of the file to the table, false (with the offending line printed) if it can't be read
+    bool load(const std::string &path);
+
+    void setDefault(const std::vector<cv::Rect> &rois);
+
+    // Gives the video (only its file name is kept) its own entry
+    void set(const std::string &video, const std::vector<cv::Rect> &rois);
+
+    // Writes the table in the same format load reads, false if the file can't be written
+    bool save(const std::string &path) const;
+
+    // The video's own entry (looked up by its file name), the default otherwise, empty if neither
+    std::vector<cv::Rect> find(const std::string &video) const;
+
+    bool empty() const;
+};
+
+#endif //ANALYSIS_TOOL_ROITABLE_H
@@ -0,0 +1,35 @@
+#include "RoiTracker.h"
+
+// Below this normalised correlation the match is more likely noise than the LED
+constexpr double MIN_MATCH_SCORE = 0.5;
+
+RoiTracker::RoiTracker(const cv::Mat &frame, const cv::Rect &roi, int maxShift) : m_maxShift(maxShift) {
+    // The ROI alone is mostly the LED, which blinks, its surroundings stay put
+    const cv::Rect bounds(0, 0, frame.cols, frame.rows);
+    m_patch = cv::Rect(roi.x - roi.width, roi.y - roi.height, roi.width * 3, roi.height * 3) & bounds;
+    m_offset = cv::Point(roi.x - m_patch.x, roi.y - m_patch.y);
+    m_size = roi.size();
+    cv::cvtColor(frame(m_patch), m_template, cv::COLOR_BGR2GRAY);
+}
+
+cv::Rect RoiTracker::track(const cv::Mat &frame) {
+    const cv::Rect bounds(0, 0, frame.cols, frame.rows);
+    const cv::Rect search = cv::Rect(m_patch.x - m_maxShift, m_patch.y - m_maxShift, m_patch.width + 2 * m_maxShift,
+                                     m_patch.height + 2 * m_maxShift) & bounds;
+
+    if (search.width >= m_patch.width && search.height >= m_patch.height) {
+        cv::Mat grey, scores;
+        cv::cvtColor(frame(search), grey, cv::COLOR_BGR2GRAY);
+        cv::matchTemplate(grey, m_template, scores, cv::TM_CCOEFF_NORMED);
+
+        double score;
+        cv::Point best;
+        cv::minMaxLoc(scores, nullptr, &score, nullptr, &best);
+        if (score >= MIN_MATCH_SCORE) {
+            m_patch.x = search.x + best.x;
+            m_patch.y = search.y + best.y;
+        }
+    }
+
+    return {m_patch.x + m_offset.x, m_patch.y + m_offset.y, m_size.width, m_size.height};
+}
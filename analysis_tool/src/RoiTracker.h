@@ -0,0 +1,30 @@
+#ifndef ANALYSIS_TOOL_ROITRACKER_H
+#define ANALYSIS_TOOL_ROITRACKER_H
+
+#pragma once
+#include <opencv2/opencv.hpp>
+
+/*
+ * Keeps an ROI on its LED while the camera drifts or shakes (--track)
+ * The ROI and its surroundings on the first frame are the template, every frame it's matched a few pixels around
+ * where it was last found. Only that small window is converted to grey and searched, so tracking costs a sliver of
+ * decoding the frame. The template is never updated, so the small errors of each match don't add up over a long
+ * recording, and a poor match (the LED hidden by a fish, say) leaves the ROI where it was.
+ */
+class RoiTracker {
+public:
+    RoiTracker(const cv::Mat &frame, const cv::Rect &roi, int maxShift);
+
+    // Where the ROI is in this frame, the frame after the last one tracked
+    cv::Rect track(const cv::Mat &frame);
+
+private:
+    cv::Mat m_template;
+    // Where the template is now, and the ROI within it
+    cv::Rect m_patch;
+    cv::Point m_offset;
+    cv::Size m_size;
+    int m_maxShift;
+};
+
+#endif //ANALYSIS_TOOL_ROITRACKER_H
@@ -0,0 +1,73 @@
+#include "StereoViews.h"
+
+#include <algorithm>
+
+// Variance the weights never divide by less than, the means are of 8-bit values so this is far below a real ROI's
+constexpr double MIN_VARIANCE = 1e-6;
+
+std::optional<cv::Rect> findPartner(const cv::Mat &frame, const cv::Rect &roi, int maxDisparity) {
+    const int half = frame.cols / 2;
+    const bool left = roi.x + roi.width <= half;
+    if (!left && roi.x < half) {
+        return std::nullopt;
+    }
+
+    const cv::Rect view(left ? half : 0, 0, half, frame.rows);
+    const cv::Rect bounds(0, 0, frame.cols, frame.rows);
+
+    // The ROI alone is mostly the LED, which may well be off in this frame, its surroundings give the match something
+    const cv::Rect patch = cv::Rect(roi.x - roi.width, roi.y - roi.height, roi.width * 3, roi.height * 3) & bounds;
+    const int shift = left ? half : -half;
+    const cv::Rect search = cv::Rect(patch.x + shift - maxDisparity, patch.y, patch.width + 2 * maxDisparity,
+                                     patch.height) & view;
+
+    int disparity = 0;
+    if (search.width >= patch.width && search.height >= patch.height) {
+        cv::Mat scores;
+        cv::matchTemplate(frame(search), frame(patch), scores, cv::TM_CCOEFF_NORMED);
+        cv::Point best;
+        cv::minMaxLoc(scores, nullptr, nullptr, nullptr, &best);
+        disparity = search.x + best.x - (patch.x + shift);
+    }
+
+    const cv::Rect partner(roi.x + shift + disparity, roi.y, roi.width, roi.height);
+    if ((partner & view) != partner) {
+        return std::nullopt;
+    }
+    return partner;
+}
+
+double viewWeight(const std::vector<double> &levels) {
+    if (levels.empty()) {
+        return 0;
+    }
+
+    double mean = 0;
+    for (double level : levels) {
+        mean += level;
+    }
+    mean /= levels.size();
+
+    double high = 0, low = 0;
+    size_t highCount = 0, lowCount = 0;
+    for (double level : levels) {
+        if (level > mean) {
+            high += level;
+            ++highCount;
+        } else {
+            low += level;
+            ++lowCount;
+        }
+    }
+    high = highCount > 0 ? high / highCount : mean;
+    low = lowCount > 0 ? low / lowCount : mean;
+
+    double variance = 0;
+    for (double level : levels) {
+        const double centre = level > mean ? high : low;
+        variance += (level - centre) * (level - centre);
+    }
+    variance /= levels.size();
+
+    return (high - low) / std::max(variance, MIN_VARIANCE);
+}
@@ -0,0 +1,31 @@
+#ifndef ANALYSIS_TOOL_STEREOVIEWS_H
+#define ANALYSIS_TOOL_STEREOVIEWS_H
+
+#pragma once
+#include <optional>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+/*
+ * svo_export writes the left and right views next to each other, so every LED is in each frame twice (--stereo)
+ * The two views see the LED through different water and at different angles, their noise is independent, so
+ * combining them gains SNR for free. The views are combined with maximal-ratio weights: each view's level swing
+ * over its noise variance.
+ */
+
+/*
+ * The same ROI in the other view, half a frame across and moved by up to maxDisparity pixels along the row (the
+ * ZED's views are rectified, so the LED can only shift horizontally). The disparity is found by matching the ROI and
+ * its surroundings against the other view, nullopt if the ROI straddles the two views or the match falls outside.
+ */
+std::optional<cv::Rect> findPartner(const cv::Mat &frame, const cv::Rect &roi, int maxDisparity);
+
+/*
+ * Maximal-ratio weight of one view from its levels over the whole video, A / sigma^2
+ * The levels are split in to the frames above and below their mean, A is the distance between the two clusters'
+ * means and sigma^2 the variance within them. No ground truth is needed and a view that only sees noise still gets
+ * a (small) weight.
+ */
+double viewWeight(const std::vector<double> &levels);
+
+#endif //ANALYSIS_TOOL_STEREOVIEWS_H
@@ -0,0 +1,54 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+WorkerPool::WorkerPool(unsigned int workers) : m_workers(std::max(workers, 1u)) {}
+
+void WorkerPool::run(size_t count, const std::function<void(size_t)> &work,
+                     const std::function<void(size_t)> &collect) const {
+    if (m_workers == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            work(i);
+            collect(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::vector<bool> done(count, false);
+    std::mutex lock;
+    std::condition_variable finished;
+
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            work(i);
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                done[i] = true;
+            }
+            finished.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < std::min<size_t>(m_workers, count); ++i) {
+        threads.emplace_back(worker);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            finished.wait(guard, [&]() { return done[i]; });
+        }
+        collect(i);
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
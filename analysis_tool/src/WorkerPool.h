@@ -0,0 +1,24 @@
+#ifndef ANALYSIS_TOOL_WORKERPOOL_H
+#define ANALYSIS_TOOL_WORKERPOOL_H
+
+#pragma once
+#include <cstddef>
+#include <functional>
+
+/*
+ * Runs numbered jobs on a fixed number of threads and hands the results back in order
+ * work(i) runs on any of the workers, collect(i) runs on the calling thread once job i and every job before it
+ * are done, so whatever collect writes or prints comes out exactly as it would from a serial loop.
+ * With a single worker nothing is spawned and the two simply alternate.
+ */
+class WorkerPool {
+private:
+    const unsigned int m_workers;
+
+public:
+    explicit WorkerPool(unsigned int workers);
+
+    void run(size_t count, const std::function<void(size_t)> &work, const std::function<void(size_t)> &collect) const;
+};
+
+#endif //ANALYSIS_TOOL_WORKERPOOL_H
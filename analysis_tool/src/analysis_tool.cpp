@@ -20,6 +20,10 @@ int main(int argc, char *argv[]) {
                 auto file = fs::path(config.location.value());
                 optional<std::string> output_val = replaceExtension(file);
 
+                if (config.autoRoiFrames.has_value()) {
+                    detectRegions(config, {file});
+                }
+
                 auto generatedData = analyseVideo(config);
                 if (generatedData.has_value()) {
                     createCSV(generatedData.value(), output_val.value());
@@ -35,6 +39,15 @@ int main(int argc, char *argv[]) {
             // make sure we have access to the folder AND it has at least one .svo file in it
             // then create a list of all svo files in the vid and just export vid with proper config
             if (fs::is_directory(config.location.value().c_str(), fs_error)) {
+                if (config.autoRoiFrames.has_value()) {
+                    vector<fs::path> videos;
+                    for (const auto &file : fs::directory_iterator(config.location.value().c_str())) {
+                        if (file.path().extension() == ".avi") {
+                            videos.push_back(file.path());
+                        }
+                    }
+                    detectRegions(config, videos);
+                }
                 analyseFolder(config);
                 return 0;
             } else {
@@ -45,6 +58,9 @@ int main(int argc, char *argv[]) {
 }
 
 void parseArgs(int argc, char *argv[], Configuration &app_config) {
+    vector<cv::Rect> rois;
+    optional<string> roiFile;
+
     for (int i = 1; i < argc; ++i) {
         // Stores the option
         string arg = argv[i];
@@ -78,10 +94,89 @@ void parseArgs(int argc, char *argv[], Configuration &app_config) {
             // Sets a flag telling us to look for the on_100fps and off_100fps files
             // to set a baseline for the dataset
             app_config.app = APP_TYPE::DATASET_ANALYSIS;
+        } else if (((arg == "-r") || (arg == "--roi")) && i + 1 < argc) {
+            auto roi = RoiTable::parseRect(argv[++i]);
+            if (!roi.has_value()) {
+                cout << "The ROI has to be given as x,y,w,h: " << argv[i] << endl;
+                showUsage();
+            }
+            rois.push_back(roi.value());
+        } else if (((arg == "-R") || (arg == "--roi-file")) && i + 1 < argc) {
+            roiFile = argv[++i];
+        } else if (((arg == "-a") || (arg == "--auto-roi")) && i + 1 < argc) {
+            app_config.autoRoiFrames = atoi(argv[++i]);
+            app_config.headless = true;
+            if (app_config.autoRoiFrames.value() < 2) {
+                cout << "The LED can't be found in less than 2 frames" << endl;
+                showUsage();
+            }
+        } else if (((arg == "-w") || (arg == "--workers")) && i + 1 < argc) {
+            const int workers = atoi(argv[++i]);
+            if (workers < 1) {
+                cout << "Frames need at least one worker" << endl;
+                showUsage();
+            }
+            app_config.workers = workers;
+        } else if (((arg == "-n") || (arg == "--segments")) && i + 1 < argc) {
+            const int segments = atoi(argv[++i]);
+            if (segments < 1) {
+                cout << "A video can't be split in to less than one segment" << endl;
+                showUsage();
+            }
+            app_config.segments = segments;
+        } else if (((arg == "-c") || (arg == "--channel")) && i + 1 < argc) {
+            app_config.channelMix = ChannelMix::parse(argv[++i]);
+            if (!app_config.channelMix.has_value()) {
+                cout << "The channel has to be blue, green, red, grey or b,g,r weights: " << argv[i] << endl;
+                showUsage();
+            }
+        } else if (((arg == "-S") || (arg == "--stereo")) && i + 1 < argc) {
+            app_config.stereoDisparity = atoi(argv[++i]);
+            if (app_config.stereoDisparity.value() < 0) {
+                cout << "The disparity searched can't be negative" << endl;
+                showUsage();
+            }
+        } else if (((arg == "-t") || (arg == "--slicer")) && i + 1 < argc) {
+            app_config.slicer = AdaptiveSlicer::parse(argv[++i]);
+            if (!app_config.slicer.has_value()) {
+                cout << "The slicer has to be midpoint, ewma or otsu: " << argv[i] << endl;
+                showUsage();
+            }
+        } else if (((arg == "-W") || (arg == "--window")) && i + 1 < argc) {
+            int window = atoi(argv[++i]);
+            if (window < 2) {
+                cout << "The slicer's window needs at least 2 frames" << endl;
+                showUsage();
+            }
+            app_config.slicerWindow = window;
+        } else if (((arg == "-T") || (arg == "--track")) && i + 1 < argc) {
+            app_config.trackShift = atoi(argv[++i]);
+            if (app_config.trackShift.value() < 1) {
+                cout << "The ROIs have to be allowed to move at least a pixel a frame to be tracked" << endl;
+                showUsage();
+            }
+        } else if (((arg == "-j") || (arg == "--jobs")) && i + 1 < argc) {
+            const int jobs = atoi(argv[++i]);
+            if (jobs < 1) {
+                cout << "At least one video has to be analysed at a time" << endl;
+                showUsage();
+            }
+            app_config.jobs = jobs;
         } else {
             cout << "Unknown option: " << argv[i] << endl;
         }
     }
+
+    // The file's entries for specific videos win over --roi, --roi wins over the file's default
+    if (roiFile.has_value() && !app_config.rois.load(roiFile.value())) {
+        exit(-1);
+    }
+    if (!rois.empty()) {
+        app_config.rois.setDefault(rois);
+    }
+    if (roiFile.has_value() || !rois.empty()) {
+        app_config.headless = true;
+    }
 }
 
 /*
@@ -95,15 +190,15 @@ void parseArgs(int argc, char *argv[], Configuration &app_config) {
  *  The more tricky solution would be using complex flag structures which would further complicate maintenance
  */
 optional<vector<LogEntry>>
-analyseVideo(Configuration &config, const optional<cv::Scalar> &ledONVal, const optional<cv::Scalar> &ledOFFVal) {
+analyseVideo(Configuration &config, const vector<cv::Scalar> &ledONVals, const vector<cv::Scalar> &ledOFFVals) {
     cv::VideoCapture video(config.location.value());
     auto frameMeans = vector<LogEntry>();
 
     MouseData roiBox;
 
     if (!video.isOpened()) {
-        cout << "Cannot open the video file" << endl;
-        exit(-1);
+        *config.console << "Cannot open the video file: " << config.location.value() << endl;
+        return {};
     }
 
     // Material frames we need
@@ -111,92 +206,481 @@ analyseVideo(Configuration &config, const optional<cv::Scalar> &ledONVal, const
 
     bool readSuccess = video.read(frame);
     if (!readSuccess) {
-        cout << "Unable to read the video" << endl;
+        *config.console << "Unable to read the video" << endl;
         return {};
     }
 
+    auto selected = selectRegions(config, frame);
+    if (!selected.has_value()) {
+        return {};
+    }
+    auto rois = selected.value();
+
+    double fps = video.get(cv::CAP_PROP_FPS);
+    double totalFrames = video.get(cv::CAP_PROP_FRAME_COUNT);
+
+    // It's a dataset if there are ground truths
+    // split the diff between each LED's ledON and ledOFF to get its threshold
+    vector<cv::Scalar> thresholds;
+    for (size_t r = 0; r < min(ledONVals.size(), ledOFFVals.size()); ++r) {
+        thresholds.push_back(getScalarAverage({ ledONVals[r], ledOFFVals[r] }));
+    }
+
+    // Each ROI's other view comes after all of the ROIs the user gave
+    const size_t regions = rois.size();
+    const bool combine = config.stereoDisparity.has_value() && config.combineViews;
+    if (config.stereoDisparity.has_value()) {
+        for (size_t r = 0; r < regions; ++r) {
+            auto partner = findPartner(frame, rois[r], config.stereoDisparity.value());
+            if (!partner.has_value()) {
+                *config.console << "The ROI " << rois[r].x << "," << rois[r].y << "," << rois[r].width << ","
+                                << rois[r].height << " of " << config.location.value()
+                                << " isn't in the other view, skipping it" << endl;
+                return {};
+            }
+            rois.push_back(partner.value());
+        }
+    }
+
+    // The views are only thresholded once they're combined
+    const vector<cv::Scalar> frameThresholds = combine ? vector<cv::Scalar>() : thresholds;
+
+    // Every ROI, the other views' too, follows its LED on its own
+    vector<RoiTracker> trackers;
+    if (config.trackShift.has_value()) {
+        for (const cv::Rect &roi : rois) {
+            trackers.emplace_back(frame, roi, config.trackShift.value());
+        }
+    }
+
+    // A segment doesn't know where the ROIs had moved to by its first frame, tracking needs the video in one piece
+    optional<vector<LogEntry>> segmentMeans;
+    if (config.segments > 1 && trackers.empty()) {
+        segmentMeans = analyseSegments(config, rois, fps, totalFrames, frameThresholds);
+    }
+    if (segmentMeans.has_value()) {
+        frameMeans = move(segmentMeans.value());
+    } else {
+        frameMeans = analysePipeline(config, video, rois, trackers, fps, totalFrames, frameThresholds);
+    }
+
+    if (combine) {
+        combineViews(frameMeans, regions, thresholds, config.channelMix);
+    }
+
+    if (config.slicer.has_value()) {
+        sliceAdaptively(frameMeans, config);
+    }
+
+    video.release();
+
+    return frameMeans;
+}
+
+/*
+ * Decodes and analyses the rest of the video from where it stands, see analyseVideo
+ */
+vector<LogEntry> analysePipeline(const Configuration &config, cv::VideoCapture &video, const vector<cv::Rect> &rois,
+                                 vector<RoiTracker> &trackers, double fps, double totalFrames,
+                                 const vector<cv::Scalar> &thresholds) {
+    auto frameMeans = vector<LogEntry>();
+
+    /*
+     * Decoding is by far the slowest part, it gets a thread of its own and only hands on copies of the ROIs.
+     * config.workers threads take the means, frames can finish out of order there so the loop at the bottom
+     * (on this thread) puts them back in order before they're logged.
+     */
+    BoundedQueue<FrameCrops> crops(FRAME_QUEUE_DEPTH);
+    BoundedQueue<pair<int, LogEntry>> entries(FRAME_QUEUE_DEPTH);
+
+    thread decoder([&]() {
+        cv::Mat frame;
+        for (int i = 0; i < totalFrames; ++i) {
+            if (!video.read(frame)) {
+                *config.console << "Found end of video" << endl;
+                break;
+            }
+
+            // These should be the ROI mats, tracking has to see the frames in order so it's done here as well
+            FrameCrops crop{i};
+            for (size_t r = 0; r < rois.size(); ++r) {
+                const cv::Rect roi = trackers.empty() ? rois[r] : trackers[r].track(frame);
+                crop.roiMasks.push_back(frame(roi).clone());
+                if (!trackers.empty()) {
+                    crop.positions.push_back(roi.tl());
+                }
+            }
+            if (!crops.push(move(crop))) {
+                break;
+            }
+        }
+        crops.close();
+    });
+
+    atomic<unsigned int> running(config.workers);
+    vector<thread> workers;
+    for (unsigned int w = 0; w < config.workers; ++w) {
+        workers.emplace_back([&]() {
+            while (auto crop = crops.pop()) {
+                LogEntry entry = analyseFrame(crop->roiMasks, (double) crop->index / fps, thresholds,
+                                              config.channelMix);
+                entry.positions = move(crop->positions);
+                entries.push({crop->index, move(entry)});
+            }
+            if (--running == 0) {
+                entries.close();
+            }
+        });
+    }
+
+    map<int, LogEntry> pending;
+    while (auto entry = entries.pop()) {
+        pending.emplace(entry->first, entry->second);
+        while (!pending.empty() && pending.begin()->first == (int) frameMeans.size()) {
+            frameMeans.push_back(pending.begin()->second);
+            pending.erase(pending.begin());
+        }
+
+        // Several videos at once would draw over each other's bars
+        if (config.jobs == 1) {
+            progressBar((float) frameMeans.size() / totalFrames, 30);
+        }
+    }
+
+    decoder.join();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    return frameMeans;
+}
+
+/*
+ * Looks for the LED in every video that wasn't given an ROI and adds what it finds to config.rois
+ * The whole table is written to DETECTED_ROI_FILE, so the next run (or anyone checking this one) can use
+ * the same ROIs with --roi-file.
+ */
+void detectRegions(Configuration &config, const vector<fs::path> &videos) {
+    bool detected = false;
+    // The LED never blinks in a dataset's ground truths, so there's nothing to find in them
+    const bool dataset = config.app.has_value() && config.app.value() == APP_TYPE::DATASET_ANALYSIS;
+    vector<fs::path> groundTruths;
+    vector<cv::Rect> found;
+
+    for (const auto &video : videos) {
+        if (!config.rois.find(video.string()).empty()) {
+            continue;
+        }
+        if (dataset && isGroundTruth(video)) {
+            groundTruths.push_back(video);
+            continue;
+        }
+
+        auto roi = RoiDetector::detect(video.string(), config.autoRoiFrames.value());
+        if (roi.has_value()) {
+            cout << "LED found in " << video.filename().string() << " at " << roi->x << "," << roi->y << ","
+                 << roi->width << "," << roi->height << endl;
+            config.rois.set(video.string(), {roi.value()});
+            found.push_back(roi.value());
+            detected = true;
+        } else {
+            cout << "No blinking LED found in the first " << config.autoRoiFrames.value() << " frames of "
+                 << video.filename().string() << endl;
+        }
+    }
+
+    // The ground truths were recorded from the same spot, they get the median of the ROIs found in the other videos
+    if (!groundTruths.empty()) {
+        if (found.empty()) {
+            cout << "No LED was found in the dataset's videos, the ground truths need an ROI from --roi or --roi-file"
+                 << endl;
+        } else {
+            auto median = [&found](const function<int(const cv::Rect &)> &field) {
+                vector<int> values;
+                for (const cv::Rect &roi : found) {
+                    values.push_back(field(roi));
+                }
+                nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+                return values[values.size() / 2];
+            };
+            const cv::Rect shared(median([](const cv::Rect &r) { return r.x; }),
+                                  median([](const cv::Rect &r) { return r.y; }),
+                                  median([](const cv::Rect &r) { return r.width; }),
+                                  median([](const cv::Rect &r) { return r.height; }));
+            for (const auto &video : groundTruths) {
+                cout << video.filename().string() << " uses the LED found in the other videos at " << shared.x << ","
+                     << shared.y << "," << shared.width << "," << shared.height << endl;
+                config.rois.set(video.string(), {shared});
+            }
+        }
+    }
+
+    if (detected && config.rois.save(DETECTED_ROI_FILE)) {
+        cout << "ROIs written to " << DETECTED_ROI_FILE << endl;
+    }
+}
+
+/*
+ * The ROIs for the video in config.location
+ * Headless runs (any ROI given with --roi/--roi-file, --auto-roi, or all of them asked for by resolveRegions) take
+ * them from the table and never touch HighGUI, a video without an entry is skipped rather than waiting on a window
+ * nobody is there to answer.
+ * Otherwise the user draws one on the first frame.
+ */
+optional<vector<cv::Rect>> selectRegions(const Configuration &config, const cv::Mat &frame) {
+    const cv::Rect bounds(0, 0, frame.cols, frame.rows);
+
+    if (config.headless) {
+        auto rois = config.rois.find(config.location.value());
+        if (rois.empty()) {
+            *config.console << "No ROI given for " << config.location.value() << ", skipping it" << endl;
+            return nullopt;
+        }
+        for (const cv::Rect &roi : rois) {
+            if ((roi & bounds) != roi) {
+                *config.console << "The ROI " << roi.x << "," << roi.y << "," << roi.width << "," << roi.height
+                                << " lies outside the " << frame.cols << "x" << frame.rows << " frames of "
+                                << config.location.value() << ", skipping it" << endl;
+                return nullopt;
+            }
+        }
+        return rois;
+    }
+
     cv::namedWindow("source vid", cv::WINDOW_FREERATIO);
     cv::imshow("source vid", frame);
 
-    auto roi = cv::selectROI("source vid", frame, true, false);
+    auto roi = cv::selectROI("source vid", frame, true, false) & bounds;
+
+    if (roi.empty()) {
+        cv::destroyAllWindows();
+        *config.console << "No ROI selected for " << config.location.value() << ", skipping it" << endl;
+        return nullopt;
+    }
 
     cv::Mat roiMask(frame, roi);
 
     cv::imshow("roi vid", roiMask);
 
-    double fps = video.get(cv::CAP_PROP_FPS);
-    double totalFrames = video.get(cv::CAP_PROP_FRAME_COUNT);
+    cv::destroyAllWindows();
 
-    int position = 0;
+    return vector<cv::Rect>{roi};
+}
 
-    cv::destroyAllWindows();
+/*
+ * Splits the video in to config.segments contiguous pieces that are decoded and analysed at the same time, each on
+ * its own cv::VideoCapture positioned with CAP_PROP_POS_FRAMES, then stitched back together in order.
+ * OpenCV seeks to the keyframe before the frame and decodes up to it, which not every container/codec gets exactly
+ * right. So each segment also decodes the frame before its first, the last one of the previous segment, and the
+ * two means have to match. If any don't (or a segment ends early) nullopt is returned and the video has to be
+ * analysed in one piece, as it is when it's too short to be worth splitting.
+ */
+optional<vector<LogEntry>> analyseSegments(const Configuration &config, const vector<cv::Rect> &rois, double fps,
+                                           double totalFrames, const vector<cv::Scalar> &thresholds) {
+    const int entries = (int) ceil(totalFrames);
+    const int count = min((int) config.segments, entries / MIN_SEGMENT_FRAMES);
+    if (count < 2) {
+        return nullopt;
+    }
+
+    vector<VideoSegment> segments(count);
+    for (int k = 0; k < count; ++k) {
+        segments[k].first = (int) ((long) entries * k / count);
+        segments[k].frames = (int) ((long) entries * (k + 1) / count) - segments[k].first;
+    }
+
+    auto frameMeans = vector<LogEntry>();
+    bool accurate = true;
+
+    WorkerPool(count).run(count, [&](size_t k) {
+        VideoSegment &segment = segments[k];
+        cv::VideoCapture video(config.location.value());
+        cv::Mat frame;
+        vector<cv::Mat> roiMasks(rois.size());
+
+        if (k == 0) {
+            // The first frame went to selecting the ROI
+            if (!video.isOpened() || !video.read(frame)) {
+                return;
+            }
+        } else {
+            if (!video.isOpened() || !video.set(cv::CAP_PROP_POS_FRAMES, segment.first) || !video.read(frame)) {
+                return;
+            }
+            // Reduced the way the logs are, so it compares equal to the previous segment's last entry
+            for (size_t r = 0; r < rois.size(); ++r) {
+                roiMasks[r] = frame(rois[r]);
+            }
+            segment.overlap = analyseFrame(roiMasks, 0, {}, config.channelMix).frameAverages;
+        }
+
+        for (int i = segment.first; i < segment.first + segment.frames; ++i) {
+            if (!video.read(frame)) {
+                break;
+            }
+            for (size_t r = 0; r < rois.size(); ++r) {
+                roiMasks[r] = frame(rois[r]);
+            }
+            segment.logs.push_back(analyseFrame(roiMasks, (double) i / fps, thresholds, config.channelMix));
+        }
+        video.release();
+    }, [&](size_t k) {
+        VideoSegment &segment = segments[k];
+
+        if (k > 0) {
+            bool matches = !segment.overlap.empty() && !frameMeans.empty();
+            for (size_t r = 0; matches && r < rois.size(); ++r) {
+                for (int c = 0; matches && c < cv::Scalar::channels; ++c) {
+                    matches = segment.overlap[r][c] == frameMeans.back().frameAverages[r][c];
+                }
+            }
+            accurate = accurate && matches;
+        }
+        // Only the last segment may run out of frames, CAP_PROP_FRAME_COUNT is an estimate for some containers
+        if ((int) segment.logs.size() < segment.frames && k + 1 < (size_t) count) {
+            accurate = false;
+        }
 
-    for (int i = 0; i < totalFrames; ++i) {
-        readSuccess = video.read(frame);
+        frameMeans.insert(frameMeans.end(), segment.logs.begin(), segment.logs.end());
+        segment.logs = vector<LogEntry>();
 
-        if (!readSuccess) {
-            cout << "Found end of video" << endl;
-            break;
+        if (config.jobs == 1) {
+            progressBar((float) frameMeans.size() / totalFrames, 30);
         }
+    });
+
+    if (!accurate) {
+        *config.console << "Seeking in " << config.location.value()
+                        << " isn't frame accurate, analysing it in one piece" << endl;
+        return nullopt;
+    }
 
-        // This should be the ROI mat
-        roiMask = frame(roi);
+    return frameMeans;
+}
 
-        cv::Scalar average = cv::mean(roiMask);
-        double deltaTime = (double)i / fps;
-        optional<int> deducedBit = nullopt;
+LogEntry analyseFrame(const vector<cv::Mat> &roiMasks, double deltaTime, const vector<cv::Scalar> &thresholds,
+                      const optional<ChannelMix> &channelMix) {
+    LogEntry entry{deltaTime};
 
-        // TODO: Make the threshold logic smart
-        if (ledONVal.has_value() && ledOFFVal.has_value()) {
-            // It's a dataset
-            // find diff between ledON and ledOFF
-            // split the diff to get threshold?
-            // deducedBit = average > threshold ? 1 : average < threshold ? 0 : nullopt;
-            auto threshold = getScalarAverage({ ledONVal.value(), ledOFFVal.value() });
+    for (size_t r = 0; r < roiMasks.size(); ++r) {
+        cv::Scalar average = channelMix.has_value() ? mixedMeans(roiMasks[r], channelMix.value())
+                                                    : cv::mean(roiMasks[r]);
+        optional<int> deducedBit = nullopt;
 
-            // Refer only to the B of the BRG values
-            if (average[0] > threshold[0]) {
+        // The ground truths' fixed threshold, with --slicer these bits are replaced by ones that follow the drift
+        if (r < thresholds.size()) {
+            // Refer only to the B of the BRG values, unless another mix was asked for
+            const ChannelMix mix = channelMix.value_or(ChannelMix{});
+            const double level = mix.apply(average);
+            const double thresholdLevel = mix.apply(thresholds[r]);
+            if (level > thresholdLevel) {
                 deducedBit = 1;
-            } else if (average[0] < threshold[0]) {
+            } else if (level < thresholdLevel) {
                 deducedBit = 0;
             } else {
                 deducedBit = nullopt;
             }
         }
 
-        frameMeans.push_back(LogEntry{
-                deltaTime,
-                average,
-                deducedBit
-        });
-        progressBar((float) position / totalFrames, 30);
+        entry.frameAverages.push_back(average);
+        entry.deducedBits.push_back(deducedBit);
     }
 
-    video.release();
+    return entry;
+}
 
-    return frameMeans;
+/*
+ * Folds the two views of each ROI in to one column set (--stereo)
+ * ROI r's view the user drew is in frameAverages[r], the other one in frameAverages[regions + r]. Both views'
+ * weights come from viewWeight over the whole video, the means logged are the weighted average of the two.
+ * With ground truth every view has its own threshold (thresholds has one per view), the bit is the sign of the
+ * weighted sum of each view's distance from its threshold.
+ */
+void combineViews(vector<LogEntry> &logs, size_t regions, const vector<cv::Scalar> &thresholds,
+                  const optional<ChannelMix> &channelMix) {
+    const ChannelMix mix = channelMix.value_or(ChannelMix{});
+
+    for (size_t r = 0; r < regions; ++r) {
+        vector<double> drawn, other;
+        for (const LogEntry &entry : logs) {
+            drawn.push_back(mix.apply(entry.frameAverages[r]));
+            other.push_back(mix.apply(entry.frameAverages[regions + r]));
+        }
+
+        double drawnWeight = viewWeight(drawn);
+        double otherWeight = viewWeight(other);
+        if (drawnWeight + otherWeight <= 0) {
+            drawnWeight = otherWeight = 1;
+        }
+        const double total = drawnWeight + otherWeight;
+        const bool thresholded = regions + r < thresholds.size();
+
+        for (LogEntry &entry : logs) {
+            const cv::Scalar &first = entry.frameAverages[r];
+            const cv::Scalar &second = entry.frameAverages[regions + r];
+
+            cv::Scalar combined;
+            for (int c = 0; c < cv::Scalar::channels; ++c) {
+                combined[c] = (drawnWeight * first[c] + otherWeight * second[c]) / total;
+            }
+
+            optional<int> deducedBit = nullopt;
+            if (thresholded) {
+                const double soft = drawnWeight * (mix.apply(first) - mix.apply(thresholds[r])) +
+                                    otherWeight * (mix.apply(second) - mix.apply(thresholds[regions + r]));
+                if (soft > 0) {
+                    deducedBit = 1;
+                } else if (soft < 0) {
+                    deducedBit = 0;
+                }
+            }
+
+            entry.frameAverages[r] = combined;
+            entry.deducedBits[r] = deducedBit;
+        }
+    }
+
+    for (LogEntry &entry : logs) {
+        entry.frameAverages.resize(regions);
+        entry.deducedBits.resize(regions);
+        if (!entry.positions.empty()) {
+            entry.positions.resize(regions);
+        }
+    }
+}
+
+/*
+ * Replaces every ROI's bits with those of an adaptive slicer (--slicer), in frame order since each slicer carries
+ * its window from one frame to the next
+ */
+void sliceAdaptively(vector<LogEntry> &logs, const Configuration &config) {
+    const ChannelMix mix = config.channelMix.value_or(ChannelMix{});
+    vector<AdaptiveSlicer> slicers;
+
+    for (LogEntry &entry : logs) {
+        while (slicers.size() < entry.frameAverages.size()) {
+            slicers.emplace_back(config.slicer.value(), config.slicerWindow);
+        }
+        for (size_t r = 0; r < entry.frameAverages.size(); ++r) {
+            entry.deducedBits[r] = slicers[r].slice(mix.apply(entry.frameAverages[r]));
+        }
+    }
 }
 
 // Pre-conditions: command line options are valid, the folder exists.
 // All this does is opens the folder, retrieves a list of .svo files
 // and then converts each video individually
 void analyseFolder(Configuration &config) {
-    Configuration tempConfig = config;
-
     if (config.app.has_value() && config.app.value() == APP_TYPE::RAW_ANALYSIS) {
+        vector<fs::path> videos;
         for (const auto &file : fs::directory_iterator(config.location.value().c_str())) {
             if (file.path().extension() == ".avi") {
-                optional<std::string> temp = file.path().string();
-                optional<std::string> output_val = replaceExtension(file.path());
-                tempConfig.location = temp;
-                tempConfig.genericOutput = output_val;
-
-                auto generatedData = analyseVideo(tempConfig);
-                if (generatedData.has_value()) {
-                    createCSV(generatedData.value(), tempConfig.genericOutput.value());
-                }
+                videos.push_back(file.path());
             }
         }
+
+        resolveRegions(config, videos);
+        analyseVideos(config, videos, {}, {}, createVideoCSV);
     } else if (config.app.has_value() && config.app.value() == APP_TYPE::DATASET_ANALYSIS) {
         // TODO: Dataset analysis
         fs::path ledOnFile;
@@ -221,6 +705,11 @@ void analyseFolder(Configuration &config) {
     }
 }
 
+bool isGroundTruth(const fs::path &video) {
+    const string filename = video.filename().string();
+    return filename.find("on") != string::npos || filename.find("off") != string::npos;
+}
+
 optional<std::string> replaceExtension(const fs::path &path) {
     if (path.empty()) {
         cout << "Path: " << path.string() << " is empty" << endl;
@@ -231,48 +720,130 @@ optional<std::string> replaceExtension(const fs::path &path) {
 
 void analyseDataset(Configuration &configuration, const fs::path &ledON, const fs::path &ledOFF) {
     // setup internal variables
-    auto tempConfig = configuration;
-    vector<cv::Scalar> scalarEntries = vector<cv::Scalar>();
-    auto getScalar = [&scalarEntries] (const LogEntry& l) { scalarEntries.push_back(l.frameAverage); };
-
-    // Sets up temporary configuration files
-    tempConfig.location = ledON.string();
-    tempConfig.genericOutput = replaceExtension(ledON);
-    auto scalarAverages = analyseVideo(tempConfig);
-    createCSV(scalarAverages.value(), ledON.filename().replace_extension().string());
-    // extract scalar averages from the logs
-    for_each(scalarAverages.value().cbegin(), scalarAverages.value().cend(), getScalar);
-    auto ledONAverage = getScalarAverage(scalarEntries);
-
-    // empty scalar entries
-    scalarEntries.clear();
-
-    tempConfig.location = ledOFF.string();
-    tempConfig.genericOutput = replaceExtension(ledOFF);
-    scalarAverages = analyseVideo(tempConfig);
-    createCSV(scalarAverages.value(), ledOFF.filename().replace_extension().string());
-    // extract the scalar averages from the logs
-    for_each(scalarAverages.value().cbegin(), scalarAverages.value().cend(), getScalar);
-    auto ledOFFAverage = getScalarAverage(scalarEntries);
+    vector<fs::path> videos;
+    // One per ROI
+    vector<cv::Scalar> ledONAverages;
+    vector<cv::Scalar> ledOFFAverages;
 
     // iterate through the rest of the directory
     for (const auto &file : fs::directory_iterator(configuration.location.value().c_str())) {
         // Ignore the ON, OFF files
-        if (file.path().filename().string().find("on") != string::npos ||
-            file.path().filename().string().find("off") != string::npos) {
+        if (isGroundTruth(file.path())) {
             continue;
         } else if (file.path().extension() == ".avi") {
-            optional<std::string> temp = file.path().string();
-            optional<std::string> output_val = replaceExtension(file.path());
-            tempConfig.location = temp;
-            tempConfig.genericOutput = output_val;
+            videos.push_back(file.path());
+        }
+    }
+
+    // All the ROIs are asked for at once, rather than again after the ground truths were analysed
+    vector<fs::path> allVideos = {ledON, ledOFF};
+    allVideos.insert(allVideos.end(), videos.begin(), videos.end());
+    resolveRegions(configuration, allVideos);
+
+    // Ground truths keep both views' columns with --stereo, each view gets a threshold of its own from them
+    Configuration groundTruthConfig = configuration;
+    groundTruthConfig.combineViews = false;
+
+    analyseVideos(groundTruthConfig, {ledON, ledOFF}, {}, {},
+                  [&](const fs::path &video, const vector<LogEntry> &logs) {
+        vector<cv::Scalar> scalarEntries = vector<cv::Scalar>();
+        size_t region = 0;
+        auto getScalar = [&scalarEntries, &region] (const LogEntry& l) {
+            scalarEntries.push_back(l.frameAverages[region]);
+        };
+
+        createCSV(logs, video.filename().replace_extension().string());
+        // extract each ROI's scalar averages from the logs
+        auto &averages = video == ledON ? ledONAverages : ledOFFAverages;
+        for (; !logs.empty() && region < logs.front().frameAverages.size(); ++region) {
+            scalarEntries.clear();
+            for_each(logs.cbegin(), logs.cend(), getScalar);
+            averages.push_back(getScalarAverage(scalarEntries));
+        }
+    });
+
+    if (ledONAverages.empty() || ledOFFAverages.empty()) {
+        cout << "The LED " << (ledONAverages.empty() ? "ON" : "OFF")
+             << " ground truth couldn't be analysed, the dataset can't be thresholded" << endl;
+        return;
+    }
 
-            auto generatedData = analyseVideo(tempConfig, ledONAverage, ledOFFAverage);
-            if (generatedData.has_value()) {
-                createCSV(generatedData.value(), tempConfig.genericOutput.value());
+    analyseVideos(configuration, videos, ledONAverages, ledOFFAverages, createVideoCSV);
+}
+
+/*
+ * Analyses the videos on config.jobs threads (one video per thread), splitting each in to no more segments than
+ * leaves a core per decoder
+ * collect gets each video's logs on this thread and in the order of videos, so the CSVs and messages are the same
+ * as from a serial run. Videos that couldn't be analysed are left out.
+ * The ROIs have to be known beforehand (resolveRegions), HighGUI only works from the main thread.
+ */
+void analyseVideos(const Configuration &config, const vector<fs::path> &videos,
+                   const vector<cv::Scalar> &ledONVals, const vector<cv::Scalar> &ledOFFVals,
+                   const function<void(const fs::path &, const vector<LogEntry> &)> &collect) {
+    vector<optional<vector<LogEntry>>> logs(videos.size());
+    // With several videos at once each one's messages are held back and printed with its results, in order
+    vector<ostringstream> messages(config.jobs > 1 ? videos.size() : 0);
+
+    // Each job splitting its video too would be jobs * segments decoders at once, the jobs share the cores instead
+    const unsigned int cores = max(1u, thread::hardware_concurrency());
+    const unsigned int segments = max(1u, min(config.segments, cores / config.jobs));
+    if (segments < config.segments) {
+        cout << "Splitting each video in to " << segments << " segments, " << config.jobs << " videos at a time would "
+             << "otherwise decode on more threads than the " << cores << " cores" << endl;
+    }
+
+    WorkerPool(config.jobs).run(videos.size(), [&](size_t i) {
+        Configuration videoConfig = config;
+        videoConfig.segments = segments;
+        videoConfig.location = videos[i].string();
+        videoConfig.genericOutput = replaceExtension(videos[i]);
+        if (!messages.empty()) {
+            videoConfig.console = &messages[i];
+        }
+        logs[i] = analyseVideo(videoConfig, ledONVals, ledOFFVals);
+    }, [&](size_t i) {
+        if (!messages.empty()) {
+            cout << messages[i].str();
+            messages[i].str("");
+        }
+        if (logs[i].has_value()) {
+            if (config.jobs > 1) {
+                cout << videos[i].filename().string() << ": " << logs[i]->size() << " frames" << endl;
             }
+            collect(videos[i], logs[i].value());
         }
+        logs[i].reset();
+    });
+}
+
+/*
+ * Asks for the ROI of every video that doesn't have one yet, before anything is analysed
+ * The run is headless from then on, so the videos can be analysed on any thread and nobody has to wait around
+ * for the next window.
+ */
+void resolveRegions(Configuration &config, const vector<fs::path> &videos) {
+    if (config.headless) {
+        return;
     }
+
+    for (const auto &video : videos) {
+        cv::VideoCapture capture(video.string());
+        cv::Mat frame;
+        if (!capture.isOpened() || !capture.read(frame)) {
+            cout << "Unable to read the video: " << video.string() << endl;
+            continue;
+        }
+
+        Configuration videoConfig = config;
+        videoConfig.location = video.string();
+        auto rois = selectRegions(videoConfig, frame);
+        if (rois.has_value()) {
+            config.rois.set(video.string(), rois.value());
+        }
+    }
+
+    config.headless = true;
 }
 
 /*
@@ -306,27 +877,73 @@ void createCSV(const vector<LogEntry> &logs, const string &filename) {
     fstream csvStream;
     csvStream.open(filename + ".csv", ios::out);
 
-    csvStream << "deltaTime" << "," << "blue" << "," << "green" << "," << "red" << "," << "bit" << "\n";
+    // A single ROI keeps the plain column names, with several each column set gets the ROI's index
+    const size_t regions = logs.empty() ? 1 : logs.front().frameAverages.size();
+    // With --track every ROI's top left corner in the frame follows its columns
+    const bool tracked = !logs.empty() && !logs.front().positions.empty();
+    csvStream << "deltaTime";
+    for (size_t r = 0; r < regions; ++r) {
+        const string suffix = regions == 1 ? "" : "_" + to_string(r);
+        csvStream << "," << "blue" << suffix << "," << "green" << suffix << "," << "red" << suffix << ","
+                  << "bit" << suffix;
+        if (tracked) {
+            csvStream << "," << "x" << suffix << "," << "y" << suffix;
+        }
+    }
+    csvStream << "\n";
 
     // frameAverage is of type double[4], we need to destructure it
     for (const LogEntry &entry : logs) {
-        if (entry.deducedBit.has_value()) {
-            csvStream << entry.deltaTime << "," << entry.frameAverage.val[0] << "," << entry.frameAverage.val[1] << ","
-                      << entry.frameAverage.val[2] << "," << entry.deducedBit.value() << "\n";
-        } else {
-            csvStream << entry.deltaTime << "," << entry.frameAverage.val[0] << "," << entry.frameAverage.val[1] << ","
-                      << entry.frameAverage.val[2] << ", N/A" << "\n";
+        csvStream << entry.deltaTime;
+        for (size_t r = 0; r < entry.frameAverages.size(); ++r) {
+            const cv::Scalar &frameAverage = entry.frameAverages[r];
+            csvStream << "," << frameAverage.val[0] << "," << frameAverage.val[1] << "," << frameAverage.val[2];
+            if (entry.deducedBits[r].has_value()) {
+                csvStream << "," << entry.deducedBits[r].value();
+            } else {
+                csvStream << ", N/A";
+            }
+            if (tracked) {
+                csvStream << "," << entry.positions[r].x << "," << entry.positions[r].y;
+            }
         }
+        csvStream << "\n";
     }
 
     csvStream.close();
 }
 
+void createVideoCSV(const fs::path &video, const vector<LogEntry> &logs) {
+    createCSV(logs, replaceExtension(video).value());
+}
+
 void showUsage() {
-    cout << "./analysis_tool -s -f <file_path> -d <folder_path> -o <output_name>" << endl;
+    cout << "./analysis_tool -s -f <file_path> -d <folder_path> -o <output_name> -r <x,y,w,h> -R <roi_file> "
+            "-a <frames> -c <channel> -S <disparity> -t <slicer> -W <window> -T <shift> -j <jobs> -w <workers> "
+            "-n <segments>" << endl;
     cout << "-s or --dataset\t: Sets the dataset flag and stipulates that the included folder path contains a full "
             "dataset that can be analysed contextually" << endl;
     cout << "-f or --file\t: File path of the avi file you want to analyse" << endl;
     cout << "-d or --folder\t: Path to a folder with svos to be analysed" << endl;
+    cout << "-r or --roi\t: ROI (x,y,w,h in pixels) used for every video instead of asking for one, repeat it for "
+            "several LEDs" << endl;
+    cout << "-R or --roi-file\t: File of per-video ROIs (<file name> x,y,w,h [x,y,w,h ...] per line, * for the "
+            "default), videos without one are skipped" << endl;
+    cout << "-a or --auto-roi\t: Finds the LED in the first <frames> frames of videos without an ROI and writes "
+            "the ROIs to " << DETECTED_ROI_FILE << endl;
+    cout << "-w or --workers\t: Threads taking the ROI means of each video's frames while another decodes them "
+            "(1 by default)" << endl;
+    cout << "-n or --segments\t: Splits each video in to this many pieces that are decoded at the same time "
+            "(1 by default)" << endl;
+    cout << "-c or --channel\t: Only sums blue, green, red, a grey mix or b,g,r weights and slices the bits on that, "
+            "the other colour columns are left 0" << endl;
+    cout << "-S or --stereo\t: Also measures every ROI in the other half of side by side videos, searching up to "
+            "<disparity> pixels along the row, and combines both views" << endl;
+    cout << "-t or --slicer\t: Decides the bits from the levels of the last frames instead of the ground truths, "
+            "with the midpoint of their range, ewma on/off averages or otsu" << endl;
+    cout << "-W or --window\t: Frames the slicer looks back over (500 by default)" << endl;
+    cout << "-T or --track\t: Follows each LED as the camera moves, up to <shift> pixels a frame, and logs where "
+            "each ROI was" << endl;
+    cout << "-j or --jobs\t: Number of videos analysed at once in folder and dataset runs (1 by default)" << endl;
     exit(-1);
 }
@@ -1,7 +1,20 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <optional>
+#include <functional>
+#include <map>
+#include <thread>
+#include <atomic>
 #include <opencv2/opencv.hpp>
+#include "RoiTable.h"
+#include "RoiDetector.h"
+#include "WorkerPool.h"
+#include "BoundedQueue.h"
+#include "RoiKernel.h"
+#include "StereoViews.h"
+#include "AdaptiveSlicer.h"
+#include "RoiTracker.h"
 
 #if __has_include(<filesystem>)
 
@@ -20,6 +33,15 @@ error "Missing the <filesystem> header."
 
 using namespace std;
 
+// Where --auto-roi writes the ROIs it found, next to the CSVs
+constexpr char DETECTED_ROI_FILE[] = "detected_rois.txt";
+// Frames the decoder may get ahead of the analysis (and the analysis ahead of the log), as ROI crops these are small
+constexpr size_t FRAME_QUEUE_DEPTH = 64;
+// Shorter segments spend more time seeking (decoding from the keyframe before them) than analysing
+constexpr int MIN_SEGMENT_FRAMES = 500;
+// Five seconds at 100 fps, several periods of the slowest blinking while the lighting barely drifts
+constexpr size_t DEFAULT_SLICER_WINDOW = 500;
+
 enum SOURCE_TYPE {
     SINGLE_VIDEO,
     FOLDER
@@ -35,10 +57,29 @@ struct MouseData {
     cv::Point points[4];
 };
 
+// One frame, with the mean and bit of each ROI in the order the ROIs were given
 struct LogEntry {
     double deltaTime{};
-    cv::Scalar frameAverage{};
-    optional<int> deducedBit{};
+    vector<cv::Scalar> frameAverages{};
+    vector<optional<int>> deducedBits{};
+    // The top left corner each ROI was measured at, only when tracking (--track)
+    vector<cv::Point> positions{};
+};
+
+// A decoded frame's ROIs on their way to the workers, and where they were cut from when tracking
+struct FrameCrops {
+    int index{};
+    vector<cv::Mat> roiMasks{};
+    vector<cv::Point> positions{};
+};
+
+// A stretch of a video analysed on its own capture (-n), entry i of the video's log is frame i + 1
+struct VideoSegment {
+    int first{};
+    int frames{};
+    vector<LogEntry> logs{};
+    // The means of the frame before first, decoded again after seeking to compare with the previous segment's last
+    vector<cv::Scalar> overlap{};
 };
 
 struct Configuration {
@@ -48,6 +89,32 @@ struct Configuration {
     optional<SOURCE_TYPE> source;
     optional<APP_TYPE> app;
     optional<std::string> genericOutput;
+    // ROIs from --roi/--roi-file, when there are any the run is headless and never opens a window
+    RoiTable rois;
+    // Frames searched for the LED of videos that weren't given an ROI (--auto-roi)
+    optional<int> autoRoiFrames;
+    // Set once every video's ROI is known up front, nothing may open a window after that
+    bool headless = false;
+    // Videos analysed at once in folder and dataset runs (-j)
+    unsigned int jobs = 1;
+    // Threads taking the means of a video's frames, next to the one decoding them (-w)
+    unsigned int workers = 1;
+    // Pieces a video is split in to and decoded at the same time by seeking (-n)
+    unsigned int segments = 1;
+    // Channel mix the bits are sliced on, only these channels are summed (--channel), cv::mean of all of them if not
+    optional<ChannelMix> channelMix;
+    // Disparity searched for each ROI's other view in side by side videos (--stereo)
+    optional<int> stereoDisparity;
+    // Whether the two views are combined in to one column set, the ground truths keep both
+    bool combineViews = true;
+    // Decides the bits from each video's own levels instead of the ground truths (--slicer)
+    optional<AdaptiveSlicer::Kind> slicer;
+    // Frames the slicer looks back over (--window)
+    size_t slicerWindow = DEFAULT_SLICER_WINDOW;
+    // Pixels an ROI may move from one frame to the next when following its LED (--track)
+    optional<int> trackShift;
+    // Where the messages about a video go, analyseVideos holds them back per video while several run at once
+    ostream *console = &cout;
 };
 
 struct Options {
@@ -61,17 +128,47 @@ void parseArgs(int argc, char *argv[], Configuration &config);
 
 void analyseFolder(Configuration &config);
 
-optional<vector<LogEntry>> analyseVideo(Configuration &config, const optional<cv::Scalar> &ledONVal = nullopt,
-                                        const optional<cv::Scalar> &ledOFFVal = nullopt);
+optional<vector<LogEntry>> analyseVideo(Configuration &config, const vector<cv::Scalar> &ledONVals = {},
+                                        const vector<cv::Scalar> &ledOFFVals = {});
+
+optional<vector<LogEntry>> analyseSegments(const Configuration &config, const vector<cv::Rect> &rois, double fps,
+                                           double totalFrames, const vector<cv::Scalar> &thresholds);
+
+vector<LogEntry> analysePipeline(const Configuration &config, cv::VideoCapture &video, const vector<cv::Rect> &rois,
+                                 vector<RoiTracker> &trackers, double fps, double totalFrames,
+                                 const vector<cv::Scalar> &thresholds);
+
+void combineViews(vector<LogEntry> &logs, size_t regions, const vector<cv::Scalar> &thresholds,
+                  const optional<ChannelMix> &channelMix);
+
+void sliceAdaptively(vector<LogEntry> &logs, const Configuration &config);
+
+LogEntry analyseFrame(const vector<cv::Mat> &roiMasks, double deltaTime, const vector<cv::Scalar> &thresholds,
+                      const optional<ChannelMix> &channelMix);
 
 void analyseDataset(Configuration &configuration, const fs::path &ledON, const fs::path &ledOFF);
 
+void analyseVideos(const Configuration &config, const vector<fs::path> &videos,
+                   const vector<cv::Scalar> &ledONVals, const vector<cv::Scalar> &ledOFFVals,
+                   const function<void(const fs::path &, const vector<LogEntry> &)> &collect);
+
+void resolveRegions(Configuration &config, const vector<fs::path> &videos);
+
 void createCSV(const vector<LogEntry> &logs, const string &filename);
 
+void createVideoCSV(const fs::path &video, const vector<LogEntry> &logs);
+
 void showUsage();
 
 cv::Scalar getScalarAverage(const vector<cv::Scalar> &scalars);
 
 optional<std::string> replaceExtension(const fs::path &path);
 
+void detectRegions(Configuration &config, const vector<fs::path> &videos);
+
+// A dataset's LED ON and OFF videos are named with "on" or "off"
+bool isGroundTruth(const fs::path &video);
+
+optional<vector<cv::Rect>> selectRegions(const Configuration &config, const cv::Mat &frame);
+
 void capturePointsCallback(int event, int x, int y, int flags, void *userdata);
\ No newline at end of file
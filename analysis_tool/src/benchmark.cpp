@@ -0,0 +1,73 @@
+/*
+ * Microbenchmark of the ROI reduction, cv::mean against the single channel SIMD kernel (--channel)
+ * Times both on ROIs of a few sizes cut out of a random side by side frame the size svo_export writes and checks
+ * they agree:
+ *  ./analysis_tool_benchmark
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <opencv2/opencv.hpp>
+#include "RoiKernel.h"
+
+using namespace std;
+
+// Each measurement runs for about this long
+constexpr double MEASURE_SECONDS = 0.5;
+
+// Nanoseconds per call of reduce
+double measure(const function<double()> &reduce) {
+    volatile double sink = 0;
+    long calls = 0;
+    long batch = 16;
+    auto start = chrono::steady_clock::now();
+    double elapsed = 0;
+
+    while (elapsed < MEASURE_SECONDS) {
+        for (long i = 0; i < batch; ++i) {
+            sink = sink + reduce();
+        }
+        calls += batch;
+        batch *= 2;
+        elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+
+    return elapsed * 1e9 / calls;
+}
+
+int main() {
+    cv::Mat frame(720, 2560, CV_8UC3);
+    cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(256));
+
+    const ChannelMix blue = ChannelMix::parse("blue").value();
+    const ChannelMix grey = ChannelMix::parse("grey").value();
+
+    printf("%-10s %14s %14s %10s %14s %10s\n", "ROI", "cv::mean", "blue", "speed-up", "grey", "speed-up");
+
+    for (int size : {8, 32, 128, 512}) {
+        // Odd offset so the rows aren't aligned, as they won't be in a real ROI
+        const cv::Mat roi = frame(cv::Rect(1001, 101, size, size));
+
+        const cv::Scalar reference = cv::mean(roi);
+        const cv::Scalar kernel = mixedMeans(roi, grey);
+        for (int c = 0; c < 3; ++c) {
+            if (fabs(reference[c] - kernel[c]) > 1e-9) {
+                printf("The kernel's mean of channel %d is %f, cv::mean's is %f\n", c, kernel[c], reference[c]);
+                return -1;
+            }
+        }
+
+        const double meanTime = measure([&]() { return cv::mean(roi)[0]; });
+        const double blueTime = measure([&]() { return mixedMeans(roi, blue)[0]; });
+        const double greyTime = measure([&]() { return grey.apply(mixedMeans(roi, grey)); });
+
+        char name[32];
+        snprintf(name, sizeof(name), "%dx%d", size, size);
+        printf("%-10s %11.0f ns %11.0f ns %9.1fx %11.0f ns %9.1fx\n", name, meanTime, blueTime, meanTime / blueTime,
+               greyTime, meanTime / greyTime);
+    }
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * Checks of the parts of the tool that don't need a video, the WorkerPool, the BoundedQueue between the pipeline's
+ * stages and the AdaptiveSlicer. Prints what failed and exits with 1 if anything did:
+ *  ./analysis_tool_checks
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+#include "AdaptiveSlicer.h"
+#include "BoundedQueue.h"
+#include "WorkerPool.h"
+
+using namespace std;
+
+int failures = 0;
+
+void expect(bool condition, const char *what) {
+    if (!condition) {
+        printf("FAILED: %s\n", what);
+        ++failures;
+    }
+}
+
+// Later jobs finish first, collect still has to see them in order and only once each is done
+void checkWorkerPool() {
+    const size_t count = 40;
+
+    for (unsigned int workers : {1u, 2u, 4u, 8u}) {
+        vector<atomic<bool>> done(count);
+        size_t next = 0;
+        bool inOrder = true;
+
+        WorkerPool(workers).run(count, [&](size_t i) {
+            this_thread::sleep_for(chrono::microseconds((count - i) * 200));
+            done[i] = true;
+        }, [&](size_t i) {
+            inOrder = inOrder && i == next && done[i];
+            ++next;
+        });
+
+        expect(inOrder, "WorkerPool collects every job in order, after its work");
+        expect(next == count, "WorkerPool collects every job");
+    }
+
+    size_t calls = 0;
+    WorkerPool(4).run(0, [&](size_t) { ++calls; }, [&](size_t) { ++calls; });
+    expect(calls == 0, "WorkerPool does nothing without jobs");
+}
+
+void checkBoundedQueue() {
+    // What was pushed before close is still popped, then nullopt, and nothing more gets in
+    BoundedQueue<int> queue(4);
+    expect(queue.push(1) && queue.push(2), "BoundedQueue takes items up to its capacity");
+    queue.close();
+    expect(!queue.push(3), "BoundedQueue refuses items once closed");
+    expect(queue.pop() == optional<int>(1) && queue.pop() == optional<int>(2), "BoundedQueue drains after close");
+    expect(!queue.pop().has_value(), "BoundedQueue returns nullopt once closed and empty");
+
+    // close wakes a consumer waiting on an empty queue
+    BoundedQueue<int> empty(1);
+    optional<int> woken = 0;
+    thread waiting([&]() { woken = empty.pop(); });
+    this_thread::sleep_for(chrono::milliseconds(10));
+    empty.close();
+    waiting.join();
+    expect(!woken.has_value(), "BoundedQueue::close wakes a waiting pop");
+
+    // One producer, several consumers, a small capacity so both sides block, every item arrives once
+    const int items = 20000;
+    const unsigned int consumers = 3;
+    BoundedQueue<int> shared(8);
+    vector<atomic<int>> seen(items);
+    vector<thread> threads;
+    for (unsigned int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&]() {
+            while (auto item = shared.pop()) {
+                ++seen[item.value()];
+            }
+        });
+    }
+    for (int i = 0; i < items; ++i) {
+        shared.push(i);
+    }
+    shared.close();
+    for (thread &consumer : threads) {
+        consumer.join();
+    }
+
+    bool once = true;
+    for (const atomic<int> &count : seen) {
+        once = once && count == 1;
+    }
+    expect(once, "BoundedQueue hands every item to exactly one consumer");
+}
+
+// Random bits with a swing of 8 levels and unit noise while the off level drifts by 40, more than the swing
+void checkAdaptiveSlicer() {
+    const int frames = 20000;
+    const size_t window = 500;
+
+    for (auto kind : {AdaptiveSlicer::Kind::MIDPOINT, AdaptiveSlicer::Kind::EWMA, AdaptiveSlicer::Kind::OTSU}) {
+        mt19937 random(1);
+        normal_distribution<double> noise(0, 1);
+        uniform_int_distribution<int> bits(0, 1);
+        AdaptiveSlicer slicer(kind, window);
+        int errors = 0, undecided = 0;
+
+        for (int i = 0; i < frames; ++i) {
+            const int bit = bits(random);
+            const double level = 60 + 40.0 * i / frames + 8 * bit + noise(random);
+            const optional<int> sliced = slicer.slice(level);
+            if (!sliced.has_value()) {
+                ++undecided;
+            } else if (sliced.value() != bit) {
+                ++errors;
+            }
+        }
+
+        expect(errors < frames / 1000, "AdaptiveSlicer follows a drifting level with under 0.1% errors");
+        expect(undecided < 10, "AdaptiveSlicer decides once it has seen an on and an off");
+
+        // Noise alone is never sliced
+        AdaptiveSlicer flat(kind, window);
+        bool silent = true;
+        for (int i = 0; i < frames; ++i) {
+            silent = silent && !flat.slice(100 + 0.2 * noise(random)).has_value();
+        }
+        expect(silent, "AdaptiveSlicer doesn't slice a level without a swing");
+    }
+}
+
+int main() {
+    checkWorkerPool();
+    checkBoundedQueue();
+    checkAdaptiveSlicer();
+
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
@@ -0,0 +1,163 @@
+/*
+ * Binary framed protocol between the arduino_receiver sketch and the host receiver
+ * Shared by the sketch, the receiver's decoder and the host-side simulator so the three can't drift apart.
+ * It only uses <stdint.h> and <string.h> so it compiles for the AVR as well.
+ *
+ * Frame layout before framing (multi-byte fields are little endian):
+ *  0-1     sequence number, increments by one every frame
+ *  2-5     micros() of the first sample in the frame
+ *  6-7     sample period in microseconds, measured over the frame's samples
+ *  8       number of samples N (1 - FRAME_MAX_SAMPLES)
+ *  9-      N 10-bit samples packed LSB first, 4 samples per 5 bytes
+ *  last    CRC-8 (polynomial 0x07) of everything before it
+ *
+ * Frames are COBS encoded so they never contain a zero byte and are terminated by a single 0x00.
+ * A receiver that starts mid-stream simply drops bytes until the next 0x00.
+ */
+
+#ifndef ARDUINO_RECEIVER_FRAMEPROTOCOL_H
+#define ARDUINO_RECEIVER_FRAMEPROTOCOL_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define FRAME_MAX_SAMPLES 32
+#define FRAME_HEADER_SIZE 9
+#define FRAME_PACKED_SIZE(n) ((((n) * 10) + 7) / 8)
+#define FRAME_MAX_RAW_SIZE (FRAME_HEADER_SIZE + FRAME_PACKED_SIZE(FRAME_MAX_SAMPLES) + 1)
+// COBS adds one byte per 254 plus the leading code byte, and the frame ends with the delimiter
+#define FRAME_MAX_ENCODED_SIZE (FRAME_MAX_RAW_SIZE + FRAME_MAX_RAW_SIZE / 254 + 2)
+#define FRAME_DELIMITER 0x00
+
+inline uint8_t frameCrc8(const uint8_t *data, uint16_t length) {
+    uint8_t crc = 0;
+    for (uint16_t i = 0; i < length; ++i) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80) ? (uint8_t) ((crc << 1) ^ 0x07) : (uint8_t) (crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Writes the COBS encoding of input followed by the delimiter, returns the bytes written
+inline uint16_t cobsEncode(const uint8_t *input, uint16_t length, uint8_t *output) {
+    uint16_t write = 1, code = 0;
+    uint8_t run = 1;
+
+    for (uint16_t read = 0; read < length; ++read) {
+        if (input[read] == 0) {
+            output[code] = run;
+            code = write++;
+            run = 1;
+        } else {
+            output[write++] = input[read];
+            if (++run == 0xFF) {
+                output[code] = run;
+                code = write++;
+                run = 1;
+            }
+        }
+    }
+    output[code] = run;
+    output[write++] = FRAME_DELIMITER;
+
+    return write;
+}
+
+// Decodes a COBS record (without its delimiter), output may alias input
+// Returns the decoded length or -1 if the record is malformed
+inline int cobsDecode(const uint8_t *input, uint16_t length, uint8_t *output) {
+    uint16_t read = 0, write = 0;
+
+    while (read < length) {
+        uint8_t code = input[read++];
+        if (code == 0 || read + code - 1 > length) {
+            return -1;
+        }
+        for (uint8_t i = 1; i < code; ++i) {
+            output[write++] = input[read++];
+        }
+        if (code != 0xFF && read < length) {
+            output[write++] = 0;
+        }
+    }
+
+    return write;
+}
+
+inline void packSample(uint8_t *packed, uint8_t index, uint16_t value) {
+    uint16_t bit = (uint16_t) index * 10;
+    uint8_t *byte = packed + (bit >> 3);
+    uint8_t shift = bit & 0x07;
+
+    value &= 0x03FF;
+    byte[0] |= (uint8_t) (value << shift);
+    byte[1] |= (uint8_t) (value >> (8 - shift));
+}
+
+inline uint16_t unpackSample(const uint8_t *packed, uint8_t index) {
+    uint16_t bit = (uint16_t) index * 10;
+    const uint8_t *byte = packed + (bit >> 3);
+    uint8_t shift = bit & 0x07;
+
+    return (uint16_t) (((byte[0] >> shift) | (byte[1] << (8 - shift))) & 0x03FF);
+}
+
+/*
+ * Collects samples and emits a complete encoded frame every FRAME_MAX_SAMPLES samples
+ * The period in the header is the average spacing of the frame's timestamps, the nominal one only stands in for a
+ * frame of a single sample. A sampling loop that falls behind then still gets every sample stamped where it was taken.
+ */
+class FrameEncoder {
+private:
+    uint16_t m_sequence = 0;
+    uint8_t m_count = 0;
+    uint8_t m_raw[FRAME_MAX_RAW_SIZE] = {0};
+    uint32_t m_first = 0;
+    uint32_t m_last = 0;
+
+public:
+    // Returns true once the frame is full and has to be finished
+    bool add(uint16_t value, uint32_t timestamp, uint16_t period) {
+        if (m_count == 0) {
+            memset(m_raw, 0, sizeof(m_raw));
+            m_raw[0] = m_sequence & 0xFF;
+            m_raw[1] = m_sequence >> 8;
+            for (uint8_t i = 0; i < 4; ++i) {
+                m_raw[2 + i] = (timestamp >> (8 * i)) & 0xFF;
+            }
+            m_raw[6] = period & 0xFF;
+            m_raw[7] = period >> 8;
+            m_first = timestamp;
+        }
+        m_last = timestamp;
+
+        packSample(m_raw + FRAME_HEADER_SIZE, m_count++, value);
+        return m_count == FRAME_MAX_SAMPLES;
+    }
+
+    // Encodes the pending samples into output (FRAME_MAX_ENCODED_SIZE bytes), returns the length to send
+    uint16_t finish(uint8_t *output) {
+        if (m_count == 0) {
+            return 0;
+        }
+
+        uint16_t length = FRAME_HEADER_SIZE + FRAME_PACKED_SIZE(m_count);
+        if (m_count > 1) {
+            // Rounded to the nearest microsecond, the subtraction is right across a micros() wrap
+            uint32_t period = (m_last - m_first + (m_count - 1) / 2) / (m_count - 1);
+            period = period > 0xFFFF ? 0xFFFF : period;
+            m_raw[6] = period & 0xFF;
+            m_raw[7] = period >> 8;
+        }
+        m_raw[8] = m_count;
+        m_raw[length] = frameCrc8(m_raw, length);
+
+        m_count = 0;
+        ++m_sequence;
+        return cobsEncode(m_raw, length + 1, output);
+    }
+};
+
+#endif //ARDUINO_RECEIVER_FRAMEPROTOCOL_H
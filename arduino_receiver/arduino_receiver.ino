@@ -1,9 +1,21 @@
 #include <Arduino.h>
+#include "FrameProtocol.h"
+
+// Microseconds between samples, 200us = 5kSPS
+// analogRead alone takes ~110us, and a frame of 32 samples is up to 52 bytes on the wire, so 5kSPS needs
+// ~8.1KB/s of the ~11.5KB/s 115200 baud carries. A faster rate needs a higher SERIAL_BAUD as well.
+#define SAMPLE_PERIOD_US 200
+// Has to match the receiver's -b/--baud, the nano's USB-serial bridge manages up to 2000000
+#define SERIAL_BAUD 115200
 
 int analogPin = A0;
-uint8_t val = 0;
+uint16_t val = 0;
+
+unsigned long wait_duration = SAMPLE_PERIOD_US;
 
-unsigned long wait_duration;
+// Samples go out in binary frames, refer to FrameProtocol.h
+FrameEncoder encoder;
+uint8_t frameBuffer[FRAME_MAX_ENCODED_SIZE];
 
 //boolean connected = false;
 //boolean newData = false;
@@ -12,7 +24,7 @@ unsigned long wait_duration;
 double pollingRate = -1;
 
 void setup() {
-    Serial.begin(115200);
+    Serial.begin(SERIAL_BAUD);
     pinMode(analogPin, INPUT);
 }
 
@@ -75,9 +87,13 @@ void loop() {
 
     val = analogRead(analogPin);
 
-    Serial.write(val);
-    Serial.write(',');
+    if (encoder.add(val, next_clock, wait_duration)) {
+        uint16_t length = encoder.finish(frameBuffer);
+        Serial.write(frameBuffer, length);
+    }
 
-    auto sleep_time = wait_duration - ((micros() - next_clock));
-    delayMicroseconds(sleep_time);
+    auto elapsed = micros() - next_clock;
+    if (elapsed < wait_duration) {
+        delayMicroseconds(wait_duration - elapsed);
+    }
 }
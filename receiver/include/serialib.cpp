@@ -17,6 +17,27 @@ This is a licence-free software, it can be used by anyone who try to build a bet
 
 #include "serialib.h"
 
+#if defined (__linux__)
+// Needed for custom baud rates and low latency mode
+#include <linux/serial.h>
+
+// <asm/termbits.h> can't be included next to <termios.h>, this mirrors the kernel's struct termios2
+struct termios2
+{
+    tcflag_t c_iflag;
+    tcflag_t c_oflag;
+    tcflag_t c_cflag;
+    tcflag_t c_lflag;
+    cc_t c_line;
+    cc_t c_cc[19];
+    speed_t c_ispeed;
+    speed_t c_ospeed;
+};
+
+#ifndef BOTHER
+#define BOTHER 0010000
+#endif
+#endif
 
 
 //_____________________________________
@@ -73,6 +94,7 @@ serialib::~serialib()
                         - 115200
                         - 128000
                         - 256000
+                        - any other rate the driver accepts
 
                \n Supported baud rate for Linux :\n
                         - 110
@@ -86,6 +108,7 @@ serialib::~serialib()
                         - 38400
                         - 57600
                         - 115200
+                        - any other rate through termios2 (e.g. 1000000, 2000000, 3000000)
 
      \return 1 success
      \return -1 device not found
@@ -135,7 +158,8 @@ int serialib::openDevice(const char *Device,const unsigned int Bauds)
     case 115200 :   dcbSerialParams.BaudRate=CBR_115200; break;
     case 128000 :   dcbSerialParams.BaudRate=CBR_128000; break;
     case 256000 :   dcbSerialParams.BaudRate=CBR_256000; break;
-    default : return -4;
+    // Any other rate is handed to the driver as is
+    default :       dcbSerialParams.BaudRate=Bauds; break;
     }
     // 8 bit data
     dcbSerialParams.ByteSize=8;
@@ -196,8 +220,13 @@ int serialib::openDevice(const char *Device,const unsigned int Bauds)
     case 38400 :    Speed=B38400; break;
     case 57600 :    Speed=B57600; break;
     case 115200 :   Speed=B115200; break;
+#if defined (__linux__)
+    // Anything else is set through termios2 once the rest of the options are written
+    default :       Speed=B38400; break;
+#else
     default : return -4;
-    }    
+#endif
+    }
     // Set the baud rate
     cfsetispeed(&options, Speed);
     cfsetospeed(&options, Speed);
@@ -210,6 +239,19 @@ int serialib::openDevice(const char *Device,const unsigned int Bauds)
     options.c_cc[VMIN]=0;
     // Activate the settings
     tcsetattr(fd, TCSANOW, &options);
+#if defined (__linux__)
+    // Custom baud rates (e.g. 1 - 3 Mbaud USB-serial bridges) need BOTHER and the exact speed
+    if (Speed==B38400 && Bauds!=38400)
+    {
+        struct termios2 customOptions;
+        if (ioctl(fd, TCGETS2, &customOptions) != 0) return -3;
+        customOptions.c_cflag &= ~CBAUD;
+        customOptions.c_cflag |= BOTHER;
+        customOptions.c_ispeed = Bauds;
+        customOptions.c_ospeed = Bauds;
+        if (ioctl(fd, TCSETS2, &customOptions) != 0) return -4;
+    }
+#endif
     // Success
     return (1);
 #endif
@@ -232,6 +274,68 @@ void serialib::closeDevice()
 
 
 
+/*!
+     \brief Set how many bytes (VMIN) and how long (VTIME, tenths of a second) the driver waits for
+            before reporting the device as readable. Only used on Linux and MacOS
+     \param minBytes : minimum number of bytes before a read is satisfied
+     \param interByteTimeout : inter-byte timeout in tenths of a second
+     \return 1 success
+     \return -3 error while getting port parameters
+     \return -5 error while writing port parameters
+  */
+int serialib::setReadThreshold(unsigned char minBytes, unsigned char interByteTimeout)
+{
+#if defined (_WIN32) || defined( _WIN64)
+    UNUSED(minBytes);
+    UNUSED(interByteTimeout);
+    return 1;
+#endif
+#if defined (__linux__) || defined(__APPLE__)
+    struct termios options;
+    if (tcgetattr(fd, &options) != 0) return -3;
+    options.c_cc[VMIN]=minBytes;
+    options.c_cc[VTIME]=interByteTimeout;
+    if (tcsetattr(fd, TCSANOW, &options) != 0) return -5;
+    return 1;
+#endif
+}
+
+
+/*!
+     \brief Ask the driver to hand received bytes over immediately instead of batching them
+            (ASYNC_LOW_LATENCY, on FTDI bridges this drops the latency timer to 1ms). Linux only
+     \param enable : true to enable the low latency mode
+     \return 1 success
+     \return -1 the driver doesn't support it (pseudo terminals, some USB bridges)
+  */
+int serialib::setLowLatency(bool enable)
+{
+#if defined (__linux__)
+    struct serial_struct serial;
+    if (ioctl(fd, TIOCGSERIAL, &serial) != 0) return -1;
+    if (enable) serial.flags |= ASYNC_LOW_LATENCY;
+    else serial.flags &= ~ASYNC_LOW_LATENCY;
+    if (ioctl(fd, TIOCSSERIAL, &serial) != 0) return -1;
+    return 1;
+#else
+    UNUSED(enable);
+    return -1;
+#endif
+}
+
+
+#if defined (__linux__) || defined(__APPLE__)
+/*!
+     \brief Return the file descriptor of the device so it can be watched with poll/epoll
+  */
+int serialib::fileDescriptor()
+{
+    return fd;
+}
+#endif
+
+
+
 
 //___________________________________________
 // ::: Read/Write operation on characters :::
@@ -573,6 +677,39 @@ int serialib::readBytes (void *buffer,unsigned int maxNbBytes,unsigned int timeO
 
 
 
+/*!
+     \brief Read whatever is already waiting on the serial device with a single read call
+     \param buffer : array of bytes read from the serial device
+     \param maxNbBytes : maximum allowed number of bytes read
+     \return >=0 return the number of bytes read, 0 if nothing was pending
+     \return -2 error while reading the bytes
+  */
+int serialib::readAvailable (void *buffer,unsigned int maxNbBytes)
+{
+#if defined (_WIN32) || defined(_WIN64)
+    // Number of bytes read
+    DWORD dwBytesRead = 0;
+
+    // Return immediately with whatever has been received
+    timeouts.ReadIntervalTimeout=MAXDWORD;
+    timeouts.ReadTotalTimeoutConstant=0;
+    timeouts.ReadTotalTimeoutMultiplier=0;
+    if(!SetCommTimeouts(hSerial, &timeouts)) return -2;
+
+    if(!ReadFile(hSerial,buffer,(DWORD)maxNbBytes,&dwBytesRead, NULL))  return -2;
+
+    return dwBytesRead;
+#endif
+#if defined (__linux__) || defined(__APPLE__)
+    // The device is opened in non-blocking mode so this never waits
+    int Ret=read(fd,buffer,maxNbBytes);
+    if (Ret==-1) return (errno==EAGAIN || errno==EWOULDBLOCK) ? 0 : -2;
+    return Ret;
+#endif
+}
+
+
+
 
 // _________________________
 // ::: Special operation :::
@@ -41,6 +41,7 @@ This is a licence-free software, it can be used by anyone who try to build a bet
     #include <fcntl.h>
     #include <unistd.h>
     #include <sys/ioctl.h>
+    #include <errno.h>
 #endif
 
 
@@ -78,6 +79,17 @@ public:
     // Close the current device
     void    closeDevice();
 
+    // Set the VMIN/VTIME read thresholds of the device
+    int     setReadThreshold(unsigned char minBytes, unsigned char interByteTimeout);
+
+    // Enable the driver's low latency mode
+    int     setLowLatency(bool enable);
+
+#if defined (__linux__) || defined(__APPLE__)
+    // File descriptor of the device
+    int     fileDescriptor();
+#endif
+
 
 
 
@@ -119,6 +131,9 @@ public:
     // Read an array of byte (with timeout)
     int     readBytes   (void *buffer,unsigned int maxNbBytes,const unsigned int timeOut_ms=0, unsigned int sleepDuration_us=100);
 
+    // Read everything already received in one call (no timeout)
+    int     readAvailable (void *buffer,unsigned int maxNbBytes);
+
 
 
 
@@ -37,3 +37,9 @@ void progressBar(int completed) {
     std::cout << "Points Captured: " << completed;
     std::cout << "\r" << std::flush;
 }
+
+// With online decoding, packets so far and the bit error rate over the known bits
+void progressBar(int completed, uint64_t packets, double bitErrorRate) {
+    std::cout << "Points Captured: " << completed << "\tPackets: " << packets << "\tBER: " << bitErrorRate;
+    std::cout << "\r" << std::flush;
+}
@@ -0,0 +1,59 @@
+#include "AckSender.h"
+
+AckSender::AckSender(const std::string &host, int port) : m_channel(host, port) {}
+
+bool AckSender::isOpen() const {
+    return m_channel.isOpen();
+}
+
+void AckSender::acknowledge(const DecodedPacket &packet) {
+    if (!packet.sequence.has_value()) {
+        return;
+    }
+    const uint8_t sequence = packet.sequence.value();
+
+    if (packet.parityOk) {
+        if (!m_highest.has_value()) {
+            m_highest = sequence;
+        }
+
+        // Sequence numbers are reused every 256 packets, the ones the window moves on to start over
+        const auto ahead = static_cast<uint8_t>(sequence - m_highest.value());
+        if (ahead > 0 && ahead <= ACK_BITS) {
+            for (uint8_t skipped = 1; skipped < ahead; ++skipped) {
+                m_states[static_cast<uint8_t>(m_highest.value() + skipped)] = LOST;
+            }
+            m_highest = sequence;
+        } else if (ahead > 0 && ahead < 256 - ACK_BITS) {
+            // Neither a recent packet nor one shortly after it
+            return;
+        }
+        m_states[sequence] = RECEIVED;
+    } else if (m_highest.has_value() && m_states[sequence] != RECEIVED &&
+               static_cast<uint8_t>(m_highest.value() - sequence) < ACK_BITS) {
+        m_states[sequence] = LOST;
+    } else {
+        return;
+    }
+
+    m_channel.send(frame());
+}
+
+AckFrame AckSender::frame() const {
+    AckFrame frame{};
+    if (!m_highest.has_value()) {
+        return frame;
+    }
+
+    frame.base = static_cast<uint8_t>(m_highest.value() - (ACK_BITS - 1));
+    for (int bit = 0; bit < ACK_BITS; ++bit) {
+        const SequenceState state = m_states[static_cast<uint8_t>(frame.base + bit)];
+        if (state == RECEIVED) {
+            frame.received |= 1u << bit;
+        } else if (state == LOST) {
+            frame.lost |= 1u << bit;
+        }
+    }
+
+    return frame;
+}
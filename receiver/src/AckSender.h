@@ -0,0 +1,48 @@
+#ifndef RECEIVER_ACKSENDER_H
+#define RECEIVER_ACKSENDER_H
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "Demodulator.h"
+// Shared with the transmitter, which listens for these
+#include "FeedbackChannel.h"
+
+// Sequence numbers an AckFrame covers, one per bitmap bit
+#define ACK_BITS 32
+
+/*
+ * Receiver end of the transmitter's selective repeat ARQ (--ack)
+ * Remembers what became of the last ACK_BITS sequence numbers and answers every decoded packet with an AckFrame
+ * covering them, ending at the highest sequence number received. A sequence number is lost when its packet failed
+ * the parity check or a later one arrived first. Only packets that pass the parity check move the window, and only
+ * by up to ACK_BITS, so a corrupted sequence number can't throw it off.
+ */
+class AckSender {
+private:
+    enum SequenceState : uint8_t {
+        UNKNOWN,
+        RECEIVED,
+        LOST
+    };
+
+    FeedbackChannel m_channel;
+    std::array<SequenceState, 256> m_states{};
+    std::optional<uint8_t> m_highest;
+
+public:
+    AckSender(const std::string &host, int port);
+
+    bool isOpen() const;
+
+    // Records the packet and sends the acknowledgement, packets without a sequence number are ignored
+    void acknowledge(const DecodedPacket &packet);
+
+    // The acknowledgement of everything seen so far
+    AckFrame frame() const;
+};
+
+#endif //RECEIVER_ACKSENDER_H
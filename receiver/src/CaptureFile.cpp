@@ -0,0 +1,262 @@
+#include "CaptureFile.h"
+
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint8_t CAPTURE_MAGIC[8] = {'V', 'L', 'C', 'C', 'A', 'P', 0, 1};
+// The device's micros() can't do any better
+constexpr uint32_t CAPTURE_TICK_NANOSECONDS = 1000;
+constexpr int CAPTURE_MAX_RUN = 255;
+
+template<typename T>
+static void putLittleEndian(std::vector<uint8_t> &buffer, T value) {
+    const size_t offset = buffer.size();
+    buffer.resize(offset + sizeof(T));
+    memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+template<typename T>
+static T getLittleEndian(const uint8_t *data) {
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+static void putVarint(std::vector<uint8_t> &buffer, int64_t value) {
+    // Zigzag, so small negative values stay short
+    auto zigzag = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    while (zigzag >= 0x80) {
+        buffer.push_back(static_cast<uint8_t>(zigzag | 0x80));
+        zigzag >>= 7;
+    }
+    buffer.push_back(static_cast<uint8_t>(zigzag));
+}
+
+// Returns false if the varint runs past end or is longer than 64 bits
+static bool getVarint(const uint8_t *&data, const uint8_t *end, int64_t &value) {
+    uint64_t zigzag = 0;
+    int shift = 0;
+    while (data < end && (*data & 0x80)) {
+        if (shift > 63) {
+            return false;
+        }
+        zigzag |= static_cast<uint64_t>(*data++ & 0x7F) << shift;
+        shift += 7;
+    }
+    if (data == end || shift > 63) {
+        return false;
+    }
+    zigzag |= static_cast<uint64_t>(*data++) << shift;
+    value = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 0x01);
+    return true;
+}
+
+CaptureWriter::CaptureWriter(const std::string &path, double adcVoltage, int adcResolution)
+        : m_file(path, std::ios::out | std::ios::binary), m_tickSeconds(CAPTURE_TICK_NANOSECONDS / 1e9) {
+    m_buffer.assign(CAPTURE_MAGIC, CAPTURE_MAGIC + sizeof(CAPTURE_MAGIC));
+    putLittleEndian<double>(m_buffer, adcVoltage);
+    putLittleEndian<uint32_t>(m_buffer, adcResolution);
+    putLittleEndian<uint32_t>(m_buffer, CAPTURE_TICK_NANOSECONDS);
+    m_file.write(reinterpret_cast<const char *>(m_buffer.data()), m_buffer.size());
+}
+
+bool CaptureWriter::isOpen() const {
+    return m_file.is_open();
+}
+
+void CaptureWriter::write(const double *times, const double *values, size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    const auto tick = [this](double time) { return static_cast<int64_t>(std::llround(time / m_tickSeconds)); };
+    const int64_t firstTick = tick(times[0]);
+    const int64_t firstDelta = count > 1 ? tick(times[1]) - firstTick : 0;
+
+    // Time column, the header is filled in once its size is known
+    m_buffer.assign(CAPTURE_BLOCK_HEADER_SIZE, 0);
+    int64_t previousTick = firstTick + firstDelta;
+    int64_t previousDelta = firstDelta;
+    int zeros = 0;
+    for (size_t i = 2; i < count; ++i) {
+        const int64_t currentTick = tick(times[i]);
+        const int64_t delta = currentTick - previousTick;
+        const int64_t deltaOfDelta = delta - previousDelta;
+        previousTick = currentTick;
+        previousDelta = delta;
+
+        if (deltaOfDelta == 0 && zeros < CAPTURE_MAX_RUN) {
+            ++zeros;
+            continue;
+        }
+        if (zeros > 0) {
+            m_buffer.push_back(0x00);
+            m_buffer.push_back(static_cast<uint8_t>(zeros));
+            zeros = 0;
+        }
+        if (deltaOfDelta == 0) {
+            // The run was full
+            zeros = 1;
+        } else {
+            putVarint(m_buffer, deltaOfDelta);
+        }
+    }
+    if (zeros > 0) {
+        m_buffer.push_back(0x00);
+        m_buffer.push_back(static_cast<uint8_t>(zeros));
+    }
+    const auto timeBytes = static_cast<uint32_t>(m_buffer.size() - CAPTURE_BLOCK_HEADER_SIZE);
+
+    // Value column
+    const size_t valuesStart = m_buffer.size();
+    m_buffer.resize(valuesStart + CAPTURE_PACKED_SIZE(count), 0);
+    uint8_t *packed = m_buffer.data() + valuesStart;
+    for (size_t i = 0; i < count; ++i) {
+        const auto value = static_cast<uint16_t>(std::lround(values[i]) & 0x03FF);
+        const size_t bit = i * 10;
+        uint8_t *byte = packed + (bit >> 3);
+        const unsigned shift = bit & 0x07;
+        byte[0] |= static_cast<uint8_t>(value << shift);
+        byte[1] |= static_cast<uint8_t>(value >> (8 - shift));
+    }
+
+    std::vector<uint8_t> header;
+    putLittleEndian<uint32_t>(header, count);
+    putLittleEndian<uint32_t>(header, timeBytes);
+    putLittleEndian<int64_t>(header, firstTick);
+    putLittleEndian<int64_t>(header, firstDelta);
+    memcpy(m_buffer.data(), header.data(), CAPTURE_BLOCK_HEADER_SIZE);
+
+    m_file.write(reinterpret_cast<const char *>(m_buffer.data()), m_buffer.size());
+}
+
+void CaptureWriter::flush() {
+    m_file.flush();
+}
+
+CaptureReader::CaptureReader(const std::string &path)
+        : m_data(nullptr), m_size(0), m_adcVoltage(0), m_adcResolution(0), m_tickSeconds(0), m_samples(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat status{};
+    if (fstat(fd, &status) == 0 && status.st_size >= CAPTURE_HEADER_SIZE) {
+        void *mapped = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            m_data = static_cast<const uint8_t *>(mapped);
+            m_size = status.st_size;
+        }
+    }
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+
+    if (m_data == nullptr || memcmp(m_data, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0) {
+        return;
+    }
+    m_adcVoltage = getLittleEndian<double>(m_data + 8);
+    m_adcResolution = getLittleEndian<uint32_t>(m_data + 16);
+    m_tickSeconds = getLittleEndian<uint32_t>(m_data + 20) / 1e9;
+
+    // Index the blocks, a block that runs past the end of the file was cut short and is left out
+    size_t offset = CAPTURE_HEADER_SIZE;
+    while (offset + CAPTURE_BLOCK_HEADER_SIZE <= m_size) {
+        const auto count = getLittleEndian<uint32_t>(m_data + offset);
+        const auto timeBytes = getLittleEndian<uint32_t>(m_data + offset + 4);
+        const size_t blockSize = CAPTURE_BLOCK_HEADER_SIZE + timeBytes + CAPTURE_PACKED_SIZE(count);
+        if (count == 0 || offset + blockSize > m_size) {
+            break;
+        }
+
+        m_blocks.push_back(Block{offset, count, m_samples});
+        m_samples += count;
+        offset += blockSize;
+    }
+}
+
+CaptureReader::~CaptureReader() {
+    if (m_data != nullptr) {
+        munmap(const_cast<uint8_t *>(m_data), m_size);
+    }
+}
+
+bool CaptureReader::isOpen() const {
+    return m_adcResolution != 0;
+}
+
+uint64_t CaptureReader::samples() const {
+    return m_samples;
+}
+
+size_t CaptureReader::blocks() const {
+    return m_blocks.size();
+}
+
+bool CaptureReader::readBlock(size_t block, std::vector<double> &times, std::vector<uint16_t> &values) const {
+    const Block &entry = m_blocks[block];
+    const uint8_t *header = m_data + entry.offset;
+    const auto timeBytes = getLittleEndian<uint32_t>(header + 4);
+    const auto firstTick = getLittleEndian<int64_t>(header + 8);
+    const auto firstDelta = getLittleEndian<int64_t>(header + 16);
+
+    times.resize(entry.count);
+    values.resize(entry.count);
+
+    // Time column
+    const uint8_t *data = header + CAPTURE_BLOCK_HEADER_SIZE;
+    const uint8_t *end = data + timeBytes;
+    int64_t tick = firstTick;
+    int64_t delta = firstDelta;
+    times[0] = tick * m_tickSeconds;
+    size_t i = 1;
+    if (entry.count > 1) {
+        tick += delta;
+        times[i++] = tick * m_tickSeconds;
+    }
+    while (i < entry.count && data < end) {
+        int run = 1;
+        int64_t deltaOfDelta = 0;
+        if (*data == 0x00) {
+            if (end - data < 2) {
+                break;
+            }
+            run = data[1];
+            data += 2;
+        } else if (!getVarint(data, end, deltaOfDelta)) {
+            break;
+        }
+
+        delta += deltaOfDelta;
+        for (; run > 0 && i < entry.count; --run) {
+            tick += delta;
+            times[i++] = tick * m_tickSeconds;
+        }
+    }
+
+    // The time column ended before every sample had a time
+    if (i < entry.count) {
+        times.clear();
+        values.clear();
+        return false;
+    }
+
+    // Value column
+    const uint8_t *packed = end;
+    for (i = 0; i < entry.count; ++i) {
+        const size_t bit = i * 10;
+        const uint8_t *byte = packed + (bit >> 3);
+        const unsigned shift = bit & 0x07;
+        values[i] = static_cast<uint16_t>(((byte[0] >> shift) | (byte[1] << (8 - shift))) & 0x03FF);
+    }
+
+    return true;
+}
+
+double CaptureReader::voltage(uint16_t value) const {
+    return (value * m_adcVoltage) / m_adcResolution;
+}
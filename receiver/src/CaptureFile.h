@@ -0,0 +1,93 @@
+#ifndef RECEIVER_CAPTUREFILE_H
+#define RECEIVER_CAPTUREFILE_H
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/*
+ * Compressed columnar capture file (.vlc)
+ *
+ * File header (24 bytes, little endian):
+ *  magic "VLCCAP\0\1" | ADC voltage (f64) | ADC resolution (u32) | nanoseconds per time tick (u32)
+ * followed by blocks, one per writer block:
+ *  sample count (u32) | time column size (u32) | first tick (i64) | first delta (i64) | time column | value column
+ *
+ * Time column: the sample times quantised to ticks, stored as the difference between consecutive deltas
+ * (zigzag varints). The samples are almost evenly spaced so nearly all of them are 0, and runs of 0 are
+ * stored as 0x00 followed by the run length.
+ * Value column: the 10-bit ADC readings bit-packed, 4 to every 5 bytes, the voltage is derived when reading.
+ *
+ * Blocks are self-contained, so a capture cut short by a crash is readable up to its last complete block.
+ *
+ * The two encodings are the block compression, nothing general purpose runs over them: the readings' noise is
+ * most of what is left, so zstd or deflate on top only takes another 12-15% off.
+ */
+
+// Size of the fixed headers
+#define CAPTURE_HEADER_SIZE 24
+#define CAPTURE_BLOCK_HEADER_SIZE 24
+// Bytes of bit-packed 10-bit values (one byte of padding so unpacking never reads past the end)
+#define CAPTURE_PACKED_SIZE(n) ((((n) * 10) + 7) / 8 + 1)
+
+class CaptureWriter {
+private:
+    std::ofstream m_file;
+    double m_tickSeconds;
+    std::vector<uint8_t> m_buffer;
+
+public:
+    CaptureWriter(const std::string &path, double adcVoltage, int adcResolution);
+
+    bool isOpen() const;
+
+    // Appends one block, times in seconds and values are the raw ADC readings
+    void write(const double *times, const double *values, size_t count);
+
+    void flush();
+};
+
+/*
+ * Memory maps a capture, only the block headers are touched when it's opened
+ * so even multi-hour captures open instantly, blocks are decoded on demand.
+ */
+class CaptureReader {
+private:
+    struct Block {
+        size_t offset;
+        uint32_t count;
+        // Index of the block's first sample in the whole capture
+        uint64_t firstSample;
+    };
+
+    const uint8_t *m_data;
+    size_t m_size;
+    double m_adcVoltage;
+    uint32_t m_adcResolution;
+    double m_tickSeconds;
+    std::vector<Block> m_blocks;
+    uint64_t m_samples;
+
+public:
+    virtual ~CaptureReader();
+
+    explicit CaptureReader(const std::string &path);
+
+    bool isOpen() const;
+
+    uint64_t samples() const;
+
+    size_t blocks() const;
+
+    // Decodes a block, times in seconds and the raw ADC readings
+    // Returns false and leaves both empty if the block's time column is corrupt
+    bool readBlock(size_t block, std::vector<double> &times, std::vector<uint16_t> &values) const;
+
+    double voltage(uint16_t value) const;
+};
+
+
+#endif //RECEIVER_CAPTUREFILE_H
@@ -0,0 +1,72 @@
+#include "ClockSync.h"
+
+// Weight kept by older pairs on every update, ~100k updates (a couple of minutes) of memory
+constexpr double FORGETTING_FACTOR = 0.99999;
+// Until the device times span a few seconds (variance in s^2) only the offset is fitted
+constexpr double MIN_VARIANCE = 1.0;
+// Transfer latency is never negative, pairs further than this (seconds) off the fit are treated as below
+constexpr double LATENCY_GATE = 5e-3;
+// A run of this many late pairs means the fit itself is wrong
+constexpr int MAX_REJECTED = 1000;
+
+ClockSync::ClockSync() : m_weight(0), m_meanX(0), m_meanY(0), m_varX(0), m_covXY(0), m_slope(1),
+                         m_origin(0), m_ready(false), m_rejected(0), m_lastRaw(0), m_wraps(0) {}
+
+uint64_t ClockSync::unwrap(uint32_t deviceMicros) {
+    // micros() overflows every ~71.6 minutes
+    if (m_ready && deviceMicros < m_lastRaw && m_lastRaw - deviceMicros > 0x80000000u) {
+        m_wraps += 1;
+    }
+    m_lastRaw = deviceMicros;
+
+    return (m_wraps << 32) | deviceMicros;
+}
+
+void ClockSync::update(uint64_t deviceMicros, double hostSeconds) {
+    if (!m_ready) {
+        m_origin = deviceMicros;
+        m_ready = true;
+    } else {
+        const double residual = hostSeconds - toHost(deviceMicros);
+        if (residual < -LATENCY_GATE || m_rejected >= MAX_REJECTED) {
+            // Arrived earlier than the fit allows, everything before was delayed (e.g. a backlog at start-up)
+            m_weight = 0;
+            m_varX = 0;
+            m_covXY = 0;
+            m_slope = 1;
+            m_rejected = 0;
+        } else if (residual > LATENCY_GATE) {
+            // Held up in a USB burst, it would only drag the fit late
+            m_rejected += 1;
+            return;
+        }
+    }
+    m_rejected = 0;
+
+    const double x = static_cast<double>(deviceMicros - m_origin) / 1e6;
+
+    // Exponentially weighted Welford update
+    m_weight = m_weight * FORGETTING_FACTOR + 1;
+    const double dx = x - m_meanX;
+    m_meanX += dx / m_weight;
+    m_meanY += (hostSeconds - m_meanY) / m_weight;
+    m_varX = m_varX * FORGETTING_FACTOR + dx * (x - m_meanX);
+    m_covXY = m_covXY * FORGETTING_FACTOR + dx * (hostSeconds - m_meanY);
+
+    if (m_varX / m_weight > MIN_VARIANCE) {
+        m_slope = m_covXY / m_varX;
+    }
+}
+
+double ClockSync::toHost(uint64_t deviceMicros) const {
+    const double x = (static_cast<double>(deviceMicros) - static_cast<double>(m_origin)) / 1e6;
+    return m_meanY + m_slope * (x - m_meanX);
+}
+
+bool ClockSync::ready() const {
+    return m_ready;
+}
+
+double ClockSync::drift() const {
+    return (m_slope - 1) * 1e6;
+}
@@ -0,0 +1,53 @@
+#ifndef RECEIVER_CLOCKSYNC_H
+#define RECEIVER_CLOCKSYNC_H
+
+#pragma once
+#include <cstdint>
+
+/*
+ * Maps the Arduino's micros() counter on to the host clock
+ * Every update() adds a (device time, host arrival time) pair to an exponentially weighted linear regression,
+ * host = offset + slope * device, so the offset and the drift between the two crystals are tracked continuously.
+ * Samples are then stamped from their device time, which is exact to the sample period, rather than from
+ * when the host happened to read them (USB delivers them in bursts). Pairs that arrive late are skipped and one that
+ * arrives early restarts the fit, so the fit follows the lowest transfer latency.
+ */
+class ClockSync {
+private:
+    // Weighted means and co-moments of the regression (kept centred so hours of data don't lose precision)
+    // Device times are relative to the first update
+    double m_weight;
+    double m_meanX;
+    double m_meanY;
+    double m_varX;
+    double m_covXY;
+    double m_slope;
+    uint64_t m_origin;
+    bool m_ready;
+    int m_rejected;
+
+    // Unwrapping of the 32-bit counter
+    uint32_t m_lastRaw;
+    uint64_t m_wraps;
+
+public:
+    ClockSync();
+
+    // Extends the 32-bit micros() to 64 bits, values have to be passed in order
+    uint64_t unwrap(uint32_t deviceMicros);
+
+    // Adds a pair of the device time of a sample and the host time (seconds) it was received at
+    void update(uint64_t deviceMicros, double hostSeconds);
+
+    // Host time in seconds of the given device time
+    double toHost(uint64_t deviceMicros) const;
+
+    // True once at least one pair has been seen
+    bool ready() const;
+
+    // Drift of the device clock relative to the host in parts per million
+    double drift() const;
+};
+
+
+#endif //RECEIVER_CLOCKSYNC_H
@@ -0,0 +1,182 @@
+#include "Demodulator.h"
+
+#include <cmath>
+#include <utility>
+
+// Per symbol weights of the level tracking, jumping to a stronger signal and decaying otherwise
+constexpr double LEVEL_ATTACK = 0.5;
+constexpr double LEVEL_DECAY = 1.0 / 16;
+// How far apart the levels have to be, relative to the spread of the samples around them, to slice anything
+constexpr double CONTRAST_RATIO = 4;
+// Fraction of the timing error at every transition that is corrected
+constexpr double CLOCK_GAIN = 0.1;
+
+Demodulator::Demodulator(double symbolRate, bool sequenced, std::function<void(const DecodedPacket &)> onPacket)
+        : m_symbolPeriod(1.0 / symbolRate), m_sequenced(sequenced), m_onPacket(std::move(onPacket)),
+          m_high(0), m_low(0), m_spread(0), m_levelsSet(false), m_lastAbove(false), m_locked(false),
+          m_nextBoundary(0), m_integral(0), m_samples(0), m_clockSet(false), m_acquired(false),
+          m_state(HUNT), m_shift(0), m_bitCount(0), m_byte(0), m_parityBit(0),
+          m_packets(0), m_parityErrors(0), m_knownBits(0), m_bitErrors(0) {}
+
+void Demodulator::setHeaderCallback(std::function<void(double)> onHeader) {
+    m_onHeader = std::move(onHeader);
+}
+
+void Demodulator::process(double value, double time) {
+    if (!m_levelsSet) {
+        m_high = value;
+        m_low = value;
+        m_levelsSet = true;
+    }
+
+    const double threshold = (m_high + m_low) / 2;
+    const bool above = value > threshold;
+
+    if (!m_clockSet) {
+        m_nextBoundary = time + m_symbolPeriod;
+        m_lastAbove = above;
+        m_clockSet = true;
+    }
+
+    // Transitions should line up with symbol boundaries, nudge the closest one towards it
+    // Until the phase has been acquired on a locked signal, the boundary jumps straight to the crossing
+    if (above != m_lastAbove) {
+        double error = time - (m_nextBoundary - m_symbolPeriod);
+        if (error > m_symbolPeriod / 2) {
+            error -= m_symbolPeriod;
+        }
+        m_nextBoundary += (m_acquired ? CLOCK_GAIN : 1.0) * error;
+        if (!m_locked) {
+            // The symbol starts over at the crossing
+            m_integral = 0;
+            m_samples = 0;
+        }
+        m_acquired = m_locked;
+        m_lastAbove = above;
+    }
+
+    // Integrate and dump, a gap in the samples dumps empty symbols
+    while (time >= m_nextBoundary) {
+        dump(m_nextBoundary - m_symbolPeriod);
+        m_nextBoundary += m_symbolPeriod;
+    }
+    m_integral += value;
+    m_samples += 1;
+}
+
+void Demodulator::dump(double time) {
+    const double threshold = (m_high + m_low) / 2;
+    const double mean = m_samples > 0 ? m_integral / m_samples : m_low;
+    const int bit = mean > threshold;
+    m_integral = 0;
+    m_samples = 0;
+
+    // Decision directed, the symbol's level moves towards it
+    double &level = bit ? m_high : m_low;
+    const bool stronger = bit ? mean > m_high : mean < m_low;
+    m_spread += LEVEL_DECAY * (std::abs(mean - level) - m_spread);
+    level += (stronger ? LEVEL_ATTACK : LEVEL_DECAY) * (mean - level);
+
+    const bool locked = m_high - m_low > CONTRAST_RATIO * m_spread;
+    if (!locked && m_locked) {
+        // The signal is gone, drop whatever packet was in progress
+        m_state = HUNT;
+        m_shift = 0;
+        m_acquired = false;
+    }
+    m_locked = locked;
+
+    if (m_locked) {
+        slice(bit, time);
+    }
+}
+
+void Demodulator::slice(int bit, double time) {
+    m_shift = ((m_shift << 1) | bit) & 0x7F;
+
+    switch (m_state) {
+        case HUNT:
+            if (m_shift == BARKER_CODE) {
+                m_packet = DecodedPacket{};
+                m_packet.time = time - (BARKER_LENGTH - 1) * m_symbolPeriod;
+                m_state = PARITY;
+                if (m_onHeader) {
+                    m_onHeader(m_packet.time);
+                }
+            }
+            break;
+        case PARITY:
+            m_parityBit = bit;
+            m_bitCount = 0;
+            m_byte = 0;
+            m_state = m_sequenced ? SEQUENCE : PAYLOAD;
+            break;
+        case SEQUENCE:
+            m_byte = (m_byte << 1) | bit;
+            if (++m_bitCount == 8) {
+                m_packet.sequence = m_byte;
+                m_bitCount = 0;
+                m_byte = 0;
+                m_state = PAYLOAD;
+            }
+            break;
+        case PAYLOAD:
+            m_byte = (m_byte << 1) | bit;
+            if (++m_bitCount == 8) {
+                if (m_byte == 0) {
+                    // Payload characters are never 0, this is the terminator of a short packet
+                    m_packet.end = time + m_symbolPeriod;
+                    finishPacket();
+                    break;
+                }
+                m_packet.payload += static_cast<char>(m_byte);
+                m_bitCount = 0;
+                m_byte = 0;
+                if (m_packet.payload.size() == PACKET_PAYLOAD_SIZE) {
+                    m_state = TERMINATOR;
+                }
+            }
+            break;
+        case TERMINATOR:
+            // All eight terminator bits are known to be 0
+            m_knownBits.fetch_add(1, std::memory_order_relaxed);
+            if (bit) {
+                m_bitErrors.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (++m_bitCount == 8) {
+                m_packet.end = time + m_symbolPeriod;
+                finishPacket();
+            }
+            break;
+    }
+}
+
+void Demodulator::finishPacket() {
+    int parity = 0;
+    for (char c : m_packet.payload) {
+        parity ^= c & 0x01;
+    }
+    m_packet.parityOk = parity == m_parityBit;
+
+    m_packets.fetch_add(1, std::memory_order_relaxed);
+    if (!m_packet.parityOk) {
+        m_parityErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_onPacket(m_packet);
+
+    m_state = HUNT;
+    m_shift = 0;
+}
+
+uint64_t Demodulator::packets() const {
+    return m_packets.load(std::memory_order_relaxed);
+}
+
+uint64_t Demodulator::parityErrors() const {
+    return m_parityErrors.load(std::memory_order_relaxed);
+}
+
+double Demodulator::bitErrorRate() const {
+    const uint64_t known = m_knownBits.load(std::memory_order_relaxed);
+    return known == 0 ? 0 : static_cast<double>(m_bitErrors.load(std::memory_order_relaxed)) / known;
+}
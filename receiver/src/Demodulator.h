@@ -0,0 +1,109 @@
+#ifndef RECEIVER_DEMODULATOR_H
+#define RECEIVER_DEMODULATOR_H
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+
+// Mirrors transmitter/src/Packet.h
+#define PACKET_PAYLOAD_SIZE 8
+#define BARKER_LENGTH 7
+#define BARKER_CODE 0b1110010
+
+struct DecodedPacket {
+    // Time of the first header bit
+    double time{};
+    // Time the terminator ended
+    double end{};
+    std::optional<uint8_t> sequence{};
+    std::string payload{};
+    bool parityOk{};
+};
+
+/*
+ * Streaming on-off keying demodulator for the transmitter's packets
+ *  - adaptive threshold: midpoint of the on and off levels, tracked from the symbols' mean values with a fast
+ *    attack and slow decay so the first header after a quiet spell is sliced correctly. Nothing is sliced until
+ *    the levels are well apart compared to the symbols' spread around them, so noise alone never produces packets.
+ *  - clock recovery: integrate-and-dump over a symbol, the symbol boundary snaps to the first threshold crossing
+ *    after the signal appears and is then nudged towards every crossing (the transmitter's rate is known,
+ *    only the phase and small drift are tracked)
+ *  - framing: Barker-7 (1110010) search, parity bit, optional ARQ sequence number, up to 8 payload bytes
+ *    and the all-zero terminator
+ * The terminator bits are known, so their errors give a live estimate of the bit error rate.
+ */
+class Demodulator {
+private:
+    enum State {
+        HUNT,
+        PARITY,
+        SEQUENCE,
+        PAYLOAD,
+        TERMINATOR,
+    };
+
+    const double m_symbolPeriod;
+    const bool m_sequenced;
+    std::function<void(const DecodedPacket &)> m_onPacket;
+    std::function<void(double)> m_onHeader;
+
+    // Slicer
+    double m_high;
+    double m_low;
+    // Mean distance of the symbols from their level
+    double m_spread;
+    bool m_levelsSet;
+    bool m_lastAbove;
+    bool m_locked;
+
+    // Clock recovery
+    double m_nextBoundary;
+    double m_integral;
+    int m_samples;
+    bool m_clockSet;
+    // Phase taken from a crossing since the signal appeared
+    bool m_acquired;
+
+    // Framer
+    State m_state;
+    uint8_t m_shift;
+    int m_bitCount;
+    uint8_t m_byte;
+    DecodedPacket m_packet;
+    int m_parityBit;
+
+    std::atomic<uint64_t> m_packets;
+    std::atomic<uint64_t> m_parityErrors;
+    std::atomic<uint64_t> m_knownBits;
+    std::atomic<uint64_t> m_bitErrors;
+
+    // Decides the symbol that started at time from the samples integrated since
+    void dump(double time);
+
+    void slice(int bit, double time);
+
+    void finishPacket();
+
+public:
+    // symbolRate in bits per second, sequenced if the packets carry an ARQ sequence number
+    Demodulator(double symbolRate, bool sequenced, std::function<void(const DecodedPacket &)> onPacket);
+
+    // Called with the packet's start time as soon as its header has been found
+    void setHeaderCallback(std::function<void(double)> onHeader);
+
+    void process(double value, double time);
+
+    // Safe to read from other threads
+    uint64_t packets() const;
+
+    uint64_t parityErrors() const;
+
+    // Errors over the known (terminator) bits so far
+    double bitErrorRate() const;
+};
+
+
+#endif //RECEIVER_DEMODULATOR_H
@@ -0,0 +1,151 @@
+#include "Filters.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <numeric>
+
+// Fractional bits kept by the CIC's fixed point arithmetic
+constexpr int CIC_FRACTION_BITS = 8;
+constexpr int CIC_DEFAULT_STAGES = 3;
+
+BlockFilter::BlockFilter(size_t delay) : m_times(delay), m_primed(false) {}
+
+void BlockFilter::delayTimes(double *times, size_t count) {
+    const size_t delay = m_times.size();
+    if (delay == 0 || count == 0) {
+        return;
+    }
+    if (!m_primed) {
+        // Until the window has filled up the output is only as old as the first sample
+        std::fill(m_times.begin(), m_times.end(), times[0]);
+        m_primed = true;
+    }
+
+    if (count >= delay) {
+        m_carry.assign(times + count - delay, times + count);
+        std::copy_backward(times, times + count - delay, times + count);
+        std::copy(m_times.begin(), m_times.end(), times);
+    } else {
+        // Every time of a block shorter than the delay comes from earlier blocks
+        m_carry.assign(m_times.begin() + count, m_times.end());
+        m_carry.insert(m_carry.end(), times, times + count);
+        std::copy(m_times.begin(), m_times.begin() + count, times);
+    }
+    m_times.swap(m_carry);
+}
+
+MovingAverage::MovingAverage(size_t length) : BlockFilter((length - 1) / 2), m_history(length, 0),
+                                              m_index(0), m_sum(0) {}
+
+size_t MovingAverage::process(double *times, double *values, size_t count) {
+    const size_t length = m_history.size();
+
+    for (size_t i = 0; i < count;) {
+        const size_t stretch = std::min(count - i, length - m_index);
+        double *const block = values + i;
+        double *const oldest = m_history.data() + m_index;
+
+        double sum = m_sum;
+        for (size_t k = 0; k < stretch; ++k) {
+            const double value = block[k];
+            sum += value - oldest[k];
+            oldest[k] = value;
+            block[k] = sum;
+        }
+        m_sum = sum;
+
+        i += stretch;
+        m_index += stretch;
+        if (m_index == length) {
+            m_index = 0;
+            // Start the running sum over once per window so rounding errors can't build up
+            m_sum = std::accumulate(m_history.begin(), m_history.end(), 0.0);
+            block[stretch - 1] = m_sum;
+        }
+    }
+
+    const auto scale = static_cast<double>(length);
+    for (size_t i = 0; i < count; ++i) {
+        values[i] /= scale;
+    }
+    delayTimes(times, count);
+
+    return count;
+}
+
+CicDecimator::CicDecimator(size_t ratio, int stages)
+        : BlockFilter(stages * (ratio - 1) / 2), m_ratio(ratio),
+          m_gain(std::pow(static_cast<double>(ratio), stages) * (1 << CIC_FRACTION_BITS)),
+          m_integrators(stages, 0), m_combs(stages, 0), m_phase(0) {}
+
+size_t CicDecimator::process(double *times, double *values, size_t count) {
+    m_block.resize(count);
+    uint64_t *const block = m_block.data();
+
+    // Unsigned so the integrators wrap around instead of overflowing, the combs undo the wrap
+    for (size_t i = 0; i < count; ++i) {
+        block[i] = static_cast<uint64_t>(std::llround(values[i] * (1 << CIC_FRACTION_BITS)));
+    }
+    for (uint64_t &integrator : m_integrators) {
+        uint64_t sum = integrator;
+        for (size_t i = 0; i < count; ++i) {
+            sum += block[i];
+            block[i] = sum;
+        }
+        integrator = sum;
+    }
+    delayTimes(times, count);
+
+    // The first sample kept is the one that completes the ratio started in the earlier blocks
+    size_t output = 0;
+    for (size_t i = m_ratio - 1 - m_phase; i < count; i += m_ratio) {
+        uint64_t value = block[i];
+        for (uint64_t &comb : m_combs) {
+            const uint64_t difference = value - comb;
+            comb = value;
+            value = difference;
+        }
+
+        // Never overtakes i, so the block can be compacted in place
+        values[output] = static_cast<double>(static_cast<int64_t>(value)) / m_gain;
+        times[output] = times[i];
+        ++output;
+    }
+    m_phase = (m_phase + count) % m_ratio;
+
+    return output;
+}
+
+MatchedFilter::MatchedFilter(size_t symbolSamples) : MovingAverage(symbolSamples) {}
+
+std::unique_ptr<BlockFilter> makeFilter(const std::string &spec, double &sampleRate, std::optional<double> symbolRate) {
+    const std::string name = spec.substr(0, spec.find(':'));
+    std::vector<long> arguments;
+    for (size_t colon = spec.find(':'); colon != std::string::npos; colon = spec.find(':', colon + 1)) {
+        arguments.push_back(strtol(spec.c_str() + colon + 1, nullptr, 10));
+    }
+
+    if (name == "average" && arguments.size() == 1 && arguments[0] > 0) {
+        return std::make_unique<MovingAverage>(arguments[0]);
+    } else if (name == "cic" && (arguments.size() == 1 || arguments.size() == 2) && arguments[0] > 0) {
+        const int stages = arguments.size() == 2 ? static_cast<int>(arguments[1]) : CIC_DEFAULT_STAGES;
+        if (stages < 1) {
+            printf("The CIC needs at least one stage\n");
+            return nullptr;
+        }
+        sampleRate /= arguments[0];
+        return std::make_unique<CicDecimator>(arguments[0], stages);
+    } else if (name == "matched" && arguments.empty()) {
+        if (!symbolRate.has_value() || sampleRate <= 0) {
+            printf("The matched filter needs both the frequency and the symbol rate\n");
+            return nullptr;
+        }
+        const auto symbolSamples = static_cast<size_t>(std::lround(sampleRate / symbolRate.value()));
+        return std::make_unique<MatchedFilter>(symbolSamples > 0 ? symbolSamples : 1);
+    }
+
+    printf("Unknown filter %s\n", spec.c_str());
+    return nullptr;
+}
@@ -0,0 +1,98 @@
+#ifndef RECEIVER_FILTERS_H
+#define RECEIVER_FILTERS_H
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+/*
+ * Streaming filters applied to the samples between the ring and the output file
+ * Every filter works on a whole block at once, in place, on plain arrays of times and values, and keeps
+ * whatever state it needs across blocks so the output is the same however the samples were split up.
+ * Output samples are stamped with the time of the centre of the filter's window, so filtering doesn't shift
+ * the signal in time.
+ */
+class BlockFilter {
+private:
+    // Times of the last delay input samples, oldest first
+    std::vector<double> m_times;
+    std::vector<double> m_carry;
+    bool m_primed;
+
+protected:
+    // delay: group delay of the filter in input samples
+    explicit BlockFilter(size_t delay);
+
+    // Moves the block's times delay samples later, a copy of the block rather than a ring per sample
+    void delayTimes(double *times, size_t count);
+
+public:
+    virtual ~BlockFilter() = default;
+
+    // Filters count samples in place, returns how many are left (fewer than count for decimators)
+    virtual size_t process(double *times, double *values, size_t count) = 0;
+};
+
+/*
+ * Boxcar average of the last length samples, a running sum so the cost doesn't depend on the length
+ * The sum is a recurrence, every output needs the one before, so it runs alone over each stretch of the block that
+ * doesn't wrap the history, and the scaling that needs no earlier sample is a separate pass over the block.
+ */
+class MovingAverage : public BlockFilter {
+private:
+    std::vector<double> m_history;
+    size_t m_index;
+    double m_sum;
+
+public:
+    explicit MovingAverage(size_t length);
+
+    size_t process(double *times, double *values, size_t count) override;
+};
+
+/*
+ * Cascaded integrator-comb decimator, keeps one in every ratio samples
+ * The integrators and combs run in wrapping 64-bit fixed point, so they stay exact however long the capture runs,
+ * and the output is scaled back by the CIC's gain (ratio^stages) to stay in ADC units. Each integrator runs over
+ * the whole block before the next one, and the combs only on the samples that are kept.
+ */
+class CicDecimator : public BlockFilter {
+private:
+    const size_t m_ratio;
+    const double m_gain;
+    std::vector<uint64_t> m_integrators;
+    std::vector<uint64_t> m_combs;
+    size_t m_phase;
+    // The block in fixed point, integrated in place one stage at a time
+    std::vector<uint64_t> m_block;
+
+public:
+    CicDecimator(size_t ratio, int stages);
+
+    size_t process(double *times, double *values, size_t count) override;
+};
+
+/*
+ * Matched filter for one on-off keyed symbol
+ * The LED's pulse is rectangular, so the taps are a symbol's worth of equal weights (unit gain at DC), which is a
+ * boxcar over the symbol and costs the same whatever the symbol rate
+ */
+class MatchedFilter : public MovingAverage {
+public:
+    explicit MatchedFilter(size_t symbolSamples);
+};
+
+/*
+ * Builds a filter from its command line spec:
+ *  average:<length>, cic:<ratio>[:<stages>] or matched (needs the symbol rate)
+ * sampleRate is the rate going in to the filter and is updated to the rate coming out of it.
+ * Returns nullptr and prints why if the spec is invalid.
+ */
+std::unique_ptr<BlockFilter> makeFilter(const std::string &spec, double &sampleRate, std::optional<double> symbolRate);
+
+
+#endif //RECEIVER_FILTERS_H
@@ -0,0 +1,45 @@
+#include "FrameDecoder.h"
+
+FrameDecoder::FrameDecoder() : m_synced(false), m_nextSequence(0), m_lostSamples(0), m_corruptFrames(0) {}
+
+bool FrameDecoder::decode(char *record, size_t length, FrameView &frame) {
+    auto *bytes = reinterpret_cast<uint8_t *>(record);
+    int decoded = length <= FRAME_MAX_ENCODED_SIZE ? cobsDecode(bytes, length, bytes) : -1;
+
+    if (decoded < FRAME_HEADER_SIZE + 1 || frameCrc8(bytes, decoded - 1) != bytes[decoded - 1]) {
+        // The first record after opening the port is usually a partial frame
+        if (length > 0 && m_synced) {
+            ++m_corruptFrames;
+        }
+        return false;
+    }
+
+    frame.count = bytes[8];
+    if (frame.count == 0 || frame.count > FRAME_MAX_SAMPLES ||
+        decoded != FRAME_HEADER_SIZE + FRAME_PACKED_SIZE(frame.count) + 1) {
+        ++m_corruptFrames;
+        return false;
+    }
+
+    frame.sequence = bytes[0] | (bytes[1] << 8);
+    frame.timestamp = bytes[2] | (bytes[3] << 8) | (bytes[4] << 16) | ((uint32_t) bytes[5] << 24);
+    frame.period = bytes[6] | (bytes[7] << 8);
+    frame.packed = bytes + FRAME_HEADER_SIZE;
+
+    if (m_synced && frame.sequence != m_nextSequence) {
+        // Assumes the missing frames were full ones
+        m_lostSamples += static_cast<uint16_t>(frame.sequence - m_nextSequence) * static_cast<uint64_t>(FRAME_MAX_SAMPLES);
+    }
+    m_synced = true;
+    m_nextSequence = frame.sequence + 1;
+
+    return true;
+}
+
+uint64_t FrameDecoder::lostSamples() const {
+    return m_lostSamples;
+}
+
+uint64_t FrameDecoder::corruptFrames() const {
+    return m_corruptFrames;
+}
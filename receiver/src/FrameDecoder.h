@@ -0,0 +1,48 @@
+#ifndef RECEIVER_FRAMEDECODER_H
+#define RECEIVER_FRAMEDECODER_H
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "FrameProtocol.h"
+
+// A decoded frame, the samples are unpacked on demand straight out of the serial buffer
+struct FrameView {
+    uint16_t sequence{};
+    // micros() of the first sample
+    uint32_t timestamp{};
+    uint16_t period{};
+    uint8_t count{};
+    const uint8_t *packed{};
+
+    uint16_t sample(uint8_t index) const {
+        return unpackSample(packed, index);
+    }
+};
+
+/*
+ * Decodes the arduino_receiver's binary frames (refer to FrameProtocol.h)
+ * Records are COBS decoded in place in the serial buffer, nothing is copied.
+ * Gaps in the sequence number are counted as lost samples so drops are detectable.
+ */
+class FrameDecoder {
+private:
+    bool m_synced;
+    uint16_t m_nextSequence;
+    uint64_t m_lostSamples;
+    uint64_t m_corruptFrames;
+
+public:
+    FrameDecoder();
+
+    // Decodes a single record (the bytes between two delimiters), returns false if it isn't a valid frame
+    bool decode(char *record, size_t length, FrameView &frame);
+
+    uint64_t lostSamples() const;
+
+    uint64_t corruptFrames() const;
+};
+
+
+#endif //RECEIVER_FRAMEDECODER_H
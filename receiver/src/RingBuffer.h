@@ -0,0 +1,70 @@
+#ifndef RECEIVER_RINGBUFFER_H
+#define RECEIVER_RINGBUFFER_H
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/*
+ * Lock-free single producer, single consumer ring buffer
+ * The producer only ever writes m_head and the consumer only ever writes m_tail, so neither side
+ * takes a lock or makes a syscall. The capacity is rounded up to a power of two so wrapping is a mask.
+ */
+template<typename T>
+class RingBuffer {
+private:
+    std::vector<T> m_items;
+    size_t m_mask;
+    // Kept on separate cache lines so the two threads don't fight over them
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+
+public:
+    explicit RingBuffer(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        m_items.resize(rounded);
+        m_mask = rounded - 1;
+    }
+
+    // Producer side, returns false if the ring is full
+    bool push(const T &item) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) > m_mask) {
+            return false;
+        }
+
+        m_items[head & m_mask] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, moves up to maxItems into out and returns how many were taken
+    size_t pop(T *out, size_t maxItems) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t count = m_head.load(std::memory_order_acquire) - tail;
+        if (count > maxItems) {
+            count = maxItems;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = m_items[(tail + i) & m_mask];
+        }
+        m_tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t size() const {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const {
+        return m_mask + 1;
+    }
+};
+
+
+#endif //RECEIVER_RINGBUFFER_H
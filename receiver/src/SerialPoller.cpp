@@ -0,0 +1,73 @@
+#include "SerialPoller.h"
+
+#if defined (__linux__)
+#include <sys/epoll.h>
+#else
+#include <thread>
+#include <chrono>
+#endif
+
+SerialPoller::SerialPoller() {
+#if defined (__linux__)
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+#else
+    m_epoll = -1;
+#endif
+}
+
+bool SerialPoller::add(serialib &port, int id) {
+    if (id >= static_cast<int>(m_ports.size())) {
+        m_ports.resize(id + 1, nullptr);
+    }
+    m_ports[id] = &port;
+
+#if defined (__linux__)
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u32 = id;
+
+    return epoll_ctl(m_epoll, EPOLL_CTL_ADD, port.fileDescriptor(), &event) == 0;
+#else
+    return true;
+#endif
+}
+
+int SerialPoller::wait(int *ready, int maxReady, int timeout_ms) {
+#if defined (__linux__)
+    epoll_event events[16];
+    int count = epoll_wait(m_epoll, events, maxReady < 16 ? maxReady : 16, timeout_ms);
+    if (count < 0) {
+        // EINTR, most likely Ctrl-C
+        return 0;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        ready[i] = static_cast<int>(events[i].data.u32);
+    }
+
+    return count;
+#else
+    for (int elapsed = 0; elapsed <= timeout_ms; ++elapsed) {
+        int count = 0;
+        for (int id = 0; id < static_cast<int>(m_ports.size()) && count < maxReady; ++id) {
+            if (m_ports[id] != nullptr && m_ports[id]->available() > 0) {
+                ready[count++] = id;
+            }
+        }
+        if (count > 0) {
+            return count;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return 0;
+#endif
+}
+
+SerialPoller::~SerialPoller() {
+#if defined (__linux__)
+    if (m_epoll >= 0) {
+        close(m_epoll);
+    }
+#endif
+}
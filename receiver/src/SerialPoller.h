@@ -0,0 +1,36 @@
+#ifndef RECEIVER_SERIALPOLLER_H
+#define RECEIVER_SERIALPOLLER_H
+
+#pragma once
+#include <vector>
+
+#include "serialib.h"
+
+/*
+ * Waits for serial ports to become readable instead of polling them on a guessed schedule
+ * On Linux the ports are registered with epoll and the kernel wakes the receiver as soon as bytes
+ * arrive (subject to the ports' VMIN). Other platforms fall back to checking available() every millisecond.
+ */
+class SerialPoller {
+private:
+    int m_epoll;
+    std::vector<serialib *> m_ports;
+
+public:
+    virtual ~SerialPoller();
+
+    SerialPoller();
+
+    // Registers the port under the given id, returns false if it couldn't be watched
+    bool add(serialib &port, int id);
+
+    /*
+     * Blocks until at least one port is readable or the timeout expires
+     * The ids of the readable ports are written to ready (up to maxReady of them)
+     * Returns the number of readable ports, 0 on timeout or when interrupted by a signal
+     */
+    int wait(int *ready, int maxReady, int timeout_ms);
+};
+
+
+#endif //RECEIVER_SERIALPOLLER_H
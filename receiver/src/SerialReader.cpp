@@ -0,0 +1,12 @@
+#include "SerialReader.h"
+
+SerialReader::SerialReader(serialib &port) : m_port(port), m_fill(0) {}
+
+int SerialReader::fill() {
+    int read = m_port.readAvailable(m_buffer + m_fill, SERIAL_BUFFER_SIZE - m_fill);
+    if (read > 0) {
+        m_fill += read;
+    }
+
+    return read;
+}
@@ -0,0 +1,63 @@
+#ifndef RECEIVER_SERIALREADER_H
+#define RECEIVER_SERIALREADER_H
+
+#pragma once
+#include <cstddef>
+#include <cstring>
+
+#include "serialib.h"
+
+// Large enough to hold a few milliseconds of data at the highest baud rates
+#define SERIAL_BUFFER_SIZE 4096
+
+/*
+ * Buffered block reader on top of serialib
+ * fill() pulls everything the port has in a single read call and parse() walks the complete records
+ * in place. Partial records are carried over to the next fill() and nothing is allocated per sample.
+ */
+class SerialReader {
+private:
+    serialib &m_port;
+    char m_buffer[SERIAL_BUFFER_SIZE + 1]{};
+    size_t m_fill;
+
+public:
+    explicit SerialReader(serialib &port);
+
+    // Returns the number of bytes read, 0 if nothing was pending and < 0 on a read error
+    int fill();
+
+    /*
+     * Calls onRecord(char *record, size_t length) for every complete record ending in delimiter
+     * The delimiter is replaced with '\0' so the record can be handed straight to strtol and friends.
+     * Returns the number of records parsed.
+     */
+    template<typename Callback>
+    size_t parse(char delimiter, Callback &&onRecord) {
+        size_t records = 0;
+        char *start = m_buffer;
+        char *end = m_buffer + m_fill;
+        char *found;
+
+        while ((found = static_cast<char *>(memchr(start, delimiter, end - start))) != nullptr) {
+            *found = '\0';
+            onRecord(start, static_cast<size_t>(found - start));
+            start = found + 1;
+            ++records;
+        }
+
+        // Carry the partial record over to the front of the buffer
+        m_fill = end - start;
+        if (m_fill == SERIAL_BUFFER_SIZE) {
+            // A full buffer without a single delimiter is garbage
+            m_fill = 0;
+        } else if (start != m_buffer) {
+            memmove(m_buffer, start, m_fill);
+        }
+
+        return records;
+    }
+};
+
+
+#endif //RECEIVER_SERIALREADER_H
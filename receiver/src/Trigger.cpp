@@ -0,0 +1,109 @@
+#include "Trigger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// Window of the energy detector, long enough to span several symbols
+constexpr double ENERGY_TIME_CONSTANT = 0.1;
+
+Trigger::Trigger(Mode mode, double level, double window, double preTrigger)
+        : m_mode(mode), m_level(level), m_window(window), m_preTrigger(preTrigger),
+          m_mean(0), m_energy(0), m_lastTime(0), m_primed(false),
+          m_recording(false), m_holdUntil(0), m_triggers(0), m_samples(0), m_kept(0) {}
+
+void Trigger::header(double time) {
+    m_events.emplace_back(time, true);
+}
+
+void Trigger::trailer(double time) {
+    m_events.emplace_back(time, false);
+}
+
+void Trigger::fire(double time) {
+    if (!m_recording) {
+        m_recording = true;
+        m_triggers += 1;
+    }
+    m_holdUntil = std::max(m_holdUntil, time + m_window);
+}
+
+void Trigger::process(const double *times, const double *values, size_t count,
+                      std::vector<double> &keptTimes, std::vector<double> &keptValues) {
+    for (size_t i = 0; i < count; ++i) {
+        const double time = times[i];
+        const double value = values[i];
+
+        if (m_mode == ENERGY) {
+            if (!m_primed) {
+                m_mean = value;
+                m_lastTime = time;
+                m_primed = true;
+            }
+            const double dt = time - m_lastTime;
+            m_lastTime = time;
+            const double alpha = std::min(1.0, dt / ENERGY_TIME_CONSTANT);
+            m_mean += alpha * (value - m_mean);
+            m_energy += alpha * ((value - m_mean) * (value - m_mean) - m_energy);
+            if (m_energy > m_level * m_level) {
+                fire(time);
+            }
+        }
+
+        while (!m_events.empty() && m_events.front().first <= time) {
+            if (m_events.front().second) {
+                fire(m_events.front().first);
+            } else if (m_recording) {
+                // Trailer seen, keep a margin as long as the pre-trigger after it
+                m_holdUntil = std::min(m_holdUntil, m_events.front().first + m_preTrigger);
+            }
+            m_events.pop_front();
+        }
+
+        m_samples += 1;
+        if (m_recording && time > m_holdUntil) {
+            m_recording = false;
+        }
+
+        if (m_recording) {
+            // Everything held back leads up to this sample
+            for (const auto &held : m_held) {
+                keptTimes.push_back(held.first);
+                keptValues.push_back(held.second);
+            }
+            m_kept += m_held.size() + 1;
+            m_held.clear();
+
+            keptTimes.push_back(time);
+            keptValues.push_back(value);
+        } else {
+            m_held.emplace_back(time, value);
+            while (m_held.front().first < time - m_preTrigger) {
+                m_held.pop_front();
+            }
+        }
+    }
+}
+
+uint64_t Trigger::triggers() const {
+    return m_triggers;
+}
+
+double Trigger::dutyCycle() const {
+    return m_samples == 0 ? 0 : static_cast<double>(m_kept) / m_samples;
+}
+
+std::unique_ptr<Trigger> makeTrigger(const std::string &spec, double window, double preTrigger) {
+    if (spec.compare(0, 7, "energy:") == 0) {
+        const double level = strtod(spec.c_str() + 7, nullptr);
+        if (level > 0) {
+            return std::make_unique<Trigger>(Trigger::ENERGY, level, window, preTrigger);
+        }
+    } else if (spec == "barker") {
+        return std::make_unique<Trigger>(Trigger::BARKER, 0, window, preTrigger);
+    }
+
+    printf("Unknown trigger %s\n", spec.c_str());
+    return nullptr;
+}
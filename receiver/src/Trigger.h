@@ -0,0 +1,78 @@
+#ifndef RECEIVER_TRIGGER_H
+#define RECEIVER_TRIGGER_H
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Gates which samples are kept, so the idle stretches between transmissions never reach the disk
+ * The last preTrigger seconds are held back in a ring, when the trigger fires they're kept along with everything
+ * up to window seconds after the last trigger, so the start of a transmission is never cut off.
+ *  - energy: fires while the signal's deviation from its moving mean is above level (ADC counts RMS),
+ *    an on-off keyed transmission swings between the two levels, ambient light only drifts
+ *  - barker: fires on every packet header the demodulator finds and stops once the packet's trailer was seen
+ */
+class Trigger {
+public:
+    enum Mode {
+        ENERGY,
+        BARKER,
+    };
+
+private:
+    const Mode m_mode;
+    const double m_level;
+    const double m_window;
+    const double m_preTrigger;
+
+    // Energy detector
+    double m_mean;
+    double m_energy;
+    double m_lastTime;
+    bool m_primed;
+
+    // Header (true) and trailer (false) events from the demodulator, in time order
+    std::deque<std::pair<double, bool>> m_events;
+    std::deque<std::pair<double, double>> m_held;
+    bool m_recording;
+    double m_holdUntil;
+
+    uint64_t m_triggers;
+    uint64_t m_samples;
+    uint64_t m_kept;
+
+    void fire(double time);
+
+public:
+    Trigger(Mode mode, double level, double window, double preTrigger);
+
+    // A packet header started at time (barker mode)
+    void header(double time);
+
+    // A packet's trailer ended at time (barker mode)
+    void trailer(double time);
+
+    // Appends the samples of the block that should be kept (and any held back ones the block triggered)
+    void process(const double *times, const double *values, size_t count,
+                 std::vector<double> &keptTimes, std::vector<double> &keptValues);
+
+    uint64_t triggers() const;
+
+    // Fraction of the samples that were kept
+    double dutyCycle() const;
+};
+
+/*
+ * Builds a trigger from its command line spec, energy:<level> or barker
+ * Returns nullptr and prints why if the spec is invalid.
+ */
+std::unique_ptr<Trigger> makeTrigger(const std::string &spec, double window, double preTrigger);
+
+
+#endif //RECEIVER_TRIGGER_H
@@ -0,0 +1,188 @@
+/*
+ * Throughput benchmark of the receiver's serial path
+ * Starts arduino_simulator behind a pseudo-terminal, points the receiver at it for a fixed time and reports
+ * the sustained sample rate, the samples that were dropped on the way and the receiver's CPU use:
+ *  ./receiver_benchmark -r 50000 -d 10
+ * Both executables are expected next to this one (they're built in to the same directory).
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+using namespace std;
+
+// The receiver sleeps for 2 seconds after opening the port, give it a little longer before timing it
+constexpr double RECEIVER_STARTUP = 2.5;
+
+struct BenchmarkConfig {
+    double sampleRate = 10'000;
+    double duration = 10;
+    double noise = 0;
+    string output = "benchmark";
+};
+
+void showUsage() {
+    printf("./receiver_benchmark -r <sample_rate> -d <duration> -n <noise> -o <output>\n");
+    printf("-r or --rate\t: Samples per second the simulator produces (10000 by default)\n");
+    printf("-d or --duration\t: Seconds to measure for (10 by default)\n");
+    printf("-n or --noise\t: Standard deviation of the simulated noise in ADC counts (0 by default)\n");
+    printf("-o or --output\t: Output name handed to the receiver (benchmark by default)\n");
+}
+
+void parseArgs(int argc, char *argv[], BenchmarkConfig &config) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if ((arg == "-h") || (arg == "--help")) {
+            showUsage();
+            exit(0);
+        } else if (((arg == "-r") || (arg == "--rate")) && i + 1 < argc) {
+            config.sampleRate = strtod(argv[++i], nullptr);
+        } else if (((arg == "-d") || (arg == "--duration")) && i + 1 < argc) {
+            config.duration = strtod(argv[++i], nullptr);
+        } else if (((arg == "-n") || (arg == "--noise")) && i + 1 < argc) {
+            config.noise = strtod(argv[++i], nullptr);
+        } else if (((arg == "-o") || (arg == "--output")) && i + 1 < argc) {
+            config.output = argv[++i];
+        } else {
+            printf("Unknown Option %s\n", arg.c_str());
+            showUsage();
+            exit(-1);
+        }
+    }
+}
+
+/*
+ * Runs the executable with its stdout going to a pipe, returns the child's pid and the read end in output
+ */
+pid_t spawn(const vector<string> &args, int &output) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+
+        vector<char *> argv;
+        for (const string &arg : args) {
+            argv.push_back(const_cast<char *>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+
+    close(fds[1]);
+    output = fds[0];
+    return pid;
+}
+
+// Reads the pipe until the line starting with prefix, returns the rest of it (empty on EOF)
+string readLine(int fd, const string &prefix) {
+    string line;
+    char c;
+    while (read(fd, &c, 1) == 1) {
+        if (c != '\n') {
+            line += c;
+            continue;
+        }
+        if (line.compare(0, prefix.size(), prefix) == 0) {
+            return line.substr(prefix.size());
+        }
+        line.clear();
+    }
+    return "";
+}
+
+string readAll(int fd) {
+    string contents;
+    char buffer[4096];
+    ssize_t length;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+        contents.append(buffer, length);
+    }
+    return contents;
+}
+
+int main(int argc, char *argv[]) {
+    BenchmarkConfig config{};
+    parseArgs(argc, argv, config);
+
+    string directory = argv[0];
+    directory = directory.find('/') == string::npos ? "." : directory.substr(0, directory.rfind('/'));
+
+    char number[32];
+    snprintf(number, sizeof(number), "%.0f", config.sampleRate);
+    const string rate = number;
+
+    // Runs for longer than the receiver so the receiver is the one that is stopped
+    int simulatorOutput;
+    pid_t simulator = spawn({directory + "/arduino_simulator", "-p", "-r", rate, "-n", to_string(config.noise),
+                             "-d", to_string(config.duration + RECEIVER_STARTUP + 5)}, simulatorOutput);
+    string pty = readLine(simulatorOutput, "PTY: ");
+    if (simulator < 0 || pty.empty()) {
+        printf("Unable to start the simulator\n");
+        return -1;
+    }
+
+    int receiverOutput;
+    pid_t receiver = spawn({directory + "/receiver", "-s", pty, "-f", rate, "-o", config.output}, receiverOutput);
+    if (receiver < 0) {
+        printf("Unable to start the receiver\n");
+        kill(simulator, SIGTERM);
+        return -1;
+    }
+
+    // The progress line keeps coming, the pipe has to be drained while the receiver runs
+    string receiverLog;
+    thread drain([&]() { receiverLog = readAll(receiverOutput); });
+
+    this_thread::sleep_for(chrono::duration<double>(RECEIVER_STARTUP + config.duration));
+    kill(receiver, SIGINT);
+
+    int status;
+    rusage usage{};
+    wait4(receiver, &status, 0, &usage);
+    drain.join();
+
+    kill(simulator, SIGTERM);
+    waitpid(simulator, &status, 0);
+
+    unsigned long samples = 0, lost = 0, corrupt = 0, overruns = 0;
+    double drift = 0, sustained = 0;
+    size_t summary = receiverLog.find("Log size:");
+    if (summary == string::npos ||
+        sscanf(receiverLog.c_str() + summary,
+               "Log size: %lu\tLost: %lu\tCorrupt frames: %lu\tOverruns: %lu\tClock drift: %lf ppm\tRate: %lf",
+               &samples, &lost, &corrupt, &overruns, &drift, &sustained) != 6) {
+        printf("The receiver didn't report its statistics:\n%s\n", receiverLog.c_str());
+        return -1;
+    }
+
+    const double cpu = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+                       usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    const unsigned long dropped = lost + overruns;
+
+    printf("Requested:\t%.0f samples/s\n", config.sampleRate);
+    printf("Sustained:\t%.0f samples/s\n", sustained);
+    printf("Received:\t%lu samples\n", samples);
+    printf("Dropped:\t%lu samples (%.3f%%)\n", dropped,
+           samples + dropped > 0 ? 100.0 * dropped / (samples + dropped) : 0.0);
+    printf("Corrupt frames:\t%lu\n", corrupt);
+    printf("CPU:\t%.1f%% of a core (%.2f s user, %.2f s system)\n", 100 * cpu / (RECEIVER_STARTUP + config.duration),
+           usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6, usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6);
+
+    return 0;
+}
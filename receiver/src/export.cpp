@@ -0,0 +1,52 @@
+/*
+ * Turns a compressed capture (receiver -B) back in to the receiver's CSV:
+ *  ./capture_export capture.vlc [capture.csv]
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "CaptureFile.h"
+
+using namespace std;
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 3) {
+        printf("./capture_export <capture.vlc> [output.csv]\n");
+        return -1;
+    }
+
+    const string input = argv[1];
+    string output = argc == 3 ? argv[2] : input.substr(0, input.rfind('.')) + ".csv";
+
+    CaptureReader reader(input);
+    if (!reader.isOpen()) {
+        printf("%s is not a capture file\n", input.c_str());
+        return -1;
+    }
+
+    ofstream csvStream(output, ios::out);
+    csvStream << "deltaTime" << "," << "analogValue" << "," << "voltage" << "\n";
+    // The times are exact to the microsecond
+    csvStream.setf(ios::fixed);
+    csvStream.precision(6);
+
+    vector<double> times;
+    vector<uint16_t> values;
+    uint64_t exported = 0;
+    for (size_t block = 0; block < reader.blocks(); ++block) {
+        if (!reader.readBlock(block, times, values)) {
+            printf("Block %zu is corrupt, skipping it\n", block);
+            continue;
+        }
+        exported += times.size();
+        for (size_t i = 0; i < times.size(); ++i) {
+            csvStream << times[i] << "," << values[i] << "," << reader.voltage(values[i]) << "\n";
+        }
+    }
+
+    printf("Exported %lu samples to %s\n", (unsigned long) exported, output.c_str());
+    return 0;
+}
@@ -2,17 +2,32 @@
 // Created by sherlock on 12/05/2021.
 //
 #include "receiver.h"
+#include "SerialReader.h"
+#include "SerialPoller.h"
+#include "RingBuffer.h"
+#include "FrameDecoder.h"
+#include "ClockSync.h"
+#include "Demodulator.h"
 #include "utils.h"
 
 // The COM ports on windows are referenced with \\\\.\\COM<x>
 // On linux as /dev/tty<x>
 
 // Modify these constant globals to change internals
-constexpr char SERIAL_END_CHAR = '\n';
 constexpr int ADC_RESOLUTION = 1023;
 constexpr double ADC_VOLTAGE = 5.00;
 const string ADC_READY_STRING = "Ready";
 const string ADC_CONNECTED_STRING = "Connected";
+// Longest the acquisition loop sleeps without data before checking for Ctrl-C
+constexpr int POLL_TIMEOUT_MS = 100;
+// Bytes on the wire per sample in a full binary frame
+constexpr double BYTES_PER_SAMPLE = (double) FRAME_MAX_ENCODED_SIZE / FRAME_MAX_SAMPLES;
+constexpr double WAKEUPS_PER_SECOND = 1000;
+constexpr double CONSOLE_REFRESH_RATE = 10;
+// Samples the ring can hold before acquisition starts dropping them (~1M, 16 MB)
+constexpr size_t RING_CAPACITY = 1 << 20;
+constexpr size_t WRITE_BLOCK_SIZE = 8192;
+constexpr int WRITER_IDLE_MS = 20;
 
 const vector<CLOption> PROGRAM_OPTIONS = {
         CLOption{
@@ -24,21 +39,85 @@ const vector<CLOption> PROGRAM_OPTIONS = {
         CLOption{
                 "-s",
                 "--source",
-                "Define the source of serial communication from the Arduino",
+                "Define the source of serial communication from the Arduino, repeat it to record several at once",
                 PosArg::REQ_ARG,
         },
         CLOption {
             "-f",
             "--frequency",
-            "Define the frequency of the arduino's polling rate",
+            "Define the frequency of the arduino's polling rate (used to batch serial reads)",
             PosArg::REQ_ARG,
         },
+        CLOption{
+                "-b",
+                "--baud",
+                "Define the baud rate of the serial port, anything the USB-serial bridge supports (115200 by default)",
+                PosArg::REQ_ARG,
+        },
         CLOption{
                 "-o",
                 "--output",
                 "Define the file name of the receiver data",
                 PosArg::OPT_ARG,
         },
+        CLOption{
+                "-r",
+                "--symbol-rate",
+                "Define the transmitter's bit rate to decode packets while capturing (written to <output>_packets.csv)",
+                PosArg::REQ_ARG,
+        },
+        CLOption{
+                "-a",
+                "--arq",
+                "The packets carry a sequence number (transmitter run with --arq)",
+                PosArg::NO_ARG,
+        },
+        CLOption{
+                "-k",
+                "--ack",
+                "Acknowledge the decoded packets to the transmitter's feedback channel at <host>:<port> (needs -r "
+                "and -a)",
+                PosArg::REQ_ARG,
+        },
+        CLOption{
+                "-F",
+                "--filter",
+                "Filter the samples before they're written, average:<length>, cic:<ratio>[:<stages>] or matched "
+                "(one symbol, needs -f and -r), repeat it to chain filters",
+                PosArg::REQ_ARG,
+        },
+        CLOption{
+                "-B",
+                "--binary",
+                "Write a compressed capture (<output>.vlc) of the raw readings instead of the CSV, "
+                "capture_export turns it back in to CSV",
+                PosArg::NO_ARG,
+        },
+        CLOption{
+                "-T",
+                "--trigger",
+                "Only keep the samples around transmissions, energy:<RMS ADC counts> or barker (needs -r)",
+                PosArg::REQ_ARG,
+        },
+        CLOption{
+                "-W",
+                "--trigger-window",
+                "Seconds kept after the last trigger, barker stops early on the packet's trailer (1 by default)",
+                PosArg::REQ_ARG,
+        },
+        CLOption{
+                "-P",
+                "--pre-trigger",
+                "Seconds kept from before the trigger, at least a packet header (0.5 by default)",
+                PosArg::REQ_ARG,
+        },
+        CLOption{
+                "-R",
+                "--replay",
+                "Run a recorded capture (.csv or .vlc) through the same filters, demodulator and trigger as fast as "
+                "possible instead of reading the serial ports, and report each stage's throughput",
+                PosArg::REQ_ARG,
+        },
         CLOption{
             "-t",
             "--test",
@@ -51,37 +130,72 @@ int main(int argc, char *argv[]) {
     Configuration appConfig{};
     parseArgs(argc, argv, appConfig);
 
+    if (appConfig.replay.has_value()) {
+        return replayCapture(appConfig);
+    }
+
+    if (appConfig.arduinoSources.empty()) {
+        showUsage();
+        return -1;
+    }
+
     // Setup the signal handler
     SetCtrlHandler();
 
-    serialib serialDevice;
-    int serialErr = serialDevice.openDevice(appConfig.arduinoSource.c_str(), 115200);
+    vector<unique_ptr<SerialChannel>> channels;
+    for (const string &source : appConfig.arduinoSources) {
+        auto channel = make_unique<SerialChannel>(source, RING_CAPACITY);
+        int serialErr = channel->port.openDevice(source.c_str(), appConfig.baudRate);
+        if (serialErr != 1) {
+            return serialErrorHandler(serialErr, source);
+        }
 
-    optional<vector<LogEntry>> logs;
+        // Not every driver supports it, the receiver still works without
+        channel->port.setLowLatency(true);
 
-    char *serialInputBuffer = new char[32];
+        if (!setupChannel(*channel, appConfig, channels.size())) {
+            return -1;
+        }
+        channels.push_back(std::move(channel));
+    }
 
-    if (serialErr == 1) {
-        // Sleeps for 2 seconds to make sure the arduino has time to respond
-        preciseSleep(2);
+    // Sleeps for 2 seconds to make sure the arduinos have time to reset after the ports are opened
+    preciseSleep(2);
 
-        if (serialDevice.readString(serialInputBuffer, SERIAL_END_CHAR, 32) > 0) {
-            // WE HAVE A RESPONSE FROM THE ARDUINO
-            // Serial device successfully opened
-            logs = readSerialPort(serialDevice, appConfig);
-        } else {
-            // Response is invalid
+    atomic<bool> acquisitionDone = false;
+    for (size_t i = 0; i < channels.size(); ++i) {
+        SerialChannel &channel = *channels[i];
+        // Whatever came in before then is stale, the decoder re-syncs on the next frame delimiter
+        channel.port.flushReceiver();
 
-        }
-    } else {
-        return serialErrorHandler(serialErr, appConfig);
+        // Acquisition stays on this thread, a writer thread per port streams the samples to disk
+        channel.writer = thread(writeLogs, ref(channel), getOutputName(appConfig, i, appConfig.binary ? ".vlc" : ".csv"),
+                                appConfig.binary, cref(acquisitionDone));
     }
 
-    if (logs.has_value()) {
-        printf("Log size: %zu\n", logs->size());
-        writeLogs(logs.value(), appConfig);
-    } else {
-        printf("Logs not generated\n");
+    readSerialPorts(channels, appConfig);
+
+    acquisitionDone = true;
+    for (auto &channel : channels) {
+        channel->writer.join();
+    }
+
+    for (auto &channel : channels) {
+        const CaptureStats &stats = channel->stats;
+        printf("%s\tLog size: %lu\tLost: %lu\tCorrupt frames: %lu\tOverruns: %lu\tClock drift: %.1f ppm"
+               "\tRate: %.0f samples/s\n",
+               channel->source.c_str(), (unsigned long) stats.samples, (unsigned long) stats.lost,
+               (unsigned long) stats.corrupt, (unsigned long) stats.overruns, stats.drift,
+               stats.seconds > 0 ? stats.samples / stats.seconds : 0.0);
+        if (channel->demodulator) {
+            printf("%s\tPackets: %lu\tParity errors: %lu\tBER: %.2e\n", channel->source.c_str(),
+                   (unsigned long) channel->demodulator->packets(),
+                   (unsigned long) channel->demodulator->parityErrors(), channel->demodulator->bitErrorRate());
+        }
+        if (channel->trigger) {
+            printf("%s\tTriggers: %lu\tKept: %.1f%%\n", channel->source.c_str(),
+                   (unsigned long) channel->trigger->triggers(), 100 * channel->trigger->dutyCycle());
+        }
     }
 
     // Successfully returns
@@ -97,13 +211,41 @@ void parseArgs(int argc, char **argv, Configuration &config) {
             exit(0);
         } else if ((arg == "-s") || (arg == "--source")) {
             // SERIAL PORT LOCATION
-            config.arduinoSource = argv[++i];
+            config.arduinoSources.emplace_back(argv[++i]);
         } else if ((arg == "-o") || (arg == "--output")) {
             // OUTPUT LOCATION
             config.output = argv[++i];
+        } else if ((arg == "-b") || (arg == "--baud")) {
+            // Baud Rate
+            config.baudRate = strtoul(argv[++i], nullptr, 10);
         } else if ((arg == "-f") || (arg == "--frequency")){
             // Polling Rate
             config.pollingRate = strtol(argv[++i], nullptr, 10);
+        } else if ((arg == "-r") || (arg == "--symbol-rate")) {
+            // Transmitter bit rate
+            config.symbolRate = strtod(argv[++i], nullptr);
+        } else if ((arg == "-F") || (arg == "--filter")) {
+            // Filter chain
+            config.filters.emplace_back(argv[++i]);
+        } else if ((arg == "-B") || (arg == "--binary")) {
+            // Compressed capture
+            config.binary = true;
+        } else if ((arg == "-T") || (arg == "--trigger")) {
+            // Trigger gating
+            config.trigger = argv[++i];
+        } else if ((arg == "-W") || (arg == "--trigger-window")) {
+            config.triggerWindow = strtod(argv[++i], nullptr);
+        } else if ((arg == "-P") || (arg == "--pre-trigger")) {
+            config.preTrigger = strtod(argv[++i], nullptr);
+        } else if ((arg == "-R") || (arg == "--replay")) {
+            // Offline run
+            config.replay = argv[++i];
+        } else if ((arg == "-a") || (arg == "--arq")) {
+            // Sequence numbered packets
+            config.sequenced = true;
+        } else if ((arg == "-k") || (arg == "--ack")) {
+            // ARQ feedback
+            config.ackTarget = argv[++i];
         } else if ((arg == "-t") || (arg == "--test")) {
             // Test instance
             config = getTestConfig();
@@ -114,47 +256,140 @@ void parseArgs(int argc, char **argv, Configuration &config) {
         }
     }
 
-vector<LogEntry> readSerialPort(serialib &serialPort, const Configuration &config) {
+/*
+ * Event driven acquisition loop
+ * Sleeps in epoll until the kernel reports bytes on any of the ports, then drains and parses all of them in one go.
+ * VMIN is tuned from the expected sample rate so a wake-up carries about a millisecond of samples,
+ * the poll timeout only exists so Ctrl-C and a stalled device are noticed.
+ * All ports are stamped against the same start time, so their files share one time base.
+ */
+void readSerialPorts(vector<unique_ptr<SerialChannel>> &channels, const Configuration &config) {
     using namespace chrono;
 
-    auto pollTime = getFrequency(config.pollingRate);
-
-    auto logs = vector<LogEntry>();
+    SerialPoller poller;
+    vector<int> ready(channels.size());
 
-    char *serialInputBuffer = new char[32];
+    for (size_t i = 0; i < channels.size(); ++i) {
+        channels[i]->port.setReadThreshold(getReadThreshold(config.pollingRate), 0);
+        if (!poller.add(channels[i]->port, static_cast<int>(i))) {
+            printf("Unable to watch the serial port %s\n", channels[i]->source.c_str());
+            return;
+        }
+    }
 
     const auto startTime = high_resolution_clock::now();
+    auto lastRefresh = startTime;
     while (!exit_app) {
-        auto startClock = high_resolution_clock::now();
-        if (serialPort.readString(serialInputBuffer, SERIAL_END_CHAR, 32) > 0) {
-            int analogValue = strtol(serialInputBuffer, nullptr, 10);
-            logs.push_back(
-                    LogEntry{
-                        high_resolution_clock::now() - startTime,
-                        getVoltage(analogValue),
-                        analogValue,
-                        });
+        poller.wait(ready.data(), static_cast<int>(ready.size()), POLL_TIMEOUT_MS);
+
+        // Every port is read, even on a timeout or when it wasn't reported ready, there may be fewer than VMIN
+        // bytes left over on it. That's one non-blocking read per port per wake-up.
+        for (auto &channel : channels) {
+            readChannel(*channel, duration<double>(high_resolution_clock::now() - startTime).count());
         }
-        progressBar(logs.size());
-        auto recordClock = high_resolution_clock::now();
-        double sleepTime = pollTime - ((recordClock - startClock).count() / 1e9);
-        if (sleepTime <= 0) {
-            // Negative Sleep
-            continue;
+
+        auto now = high_resolution_clock::now();
+        if (now - lastRefresh >= duration<double>(1.0 / CONSOLE_REFRESH_RATE)) {
+            uint64_t samples = 0;
+            uint64_t packets = 0;
+            double bitErrorRate = 0;
+            for (auto &channel : channels) {
+                samples += channel->stats.samples;
+                if (channel->demodulator) {
+                    packets += channel->demodulator->packets();
+                    // Worst port
+                    bitErrorRate = max(bitErrorRate, channel->demodulator->bitErrorRate());
+                }
+            }
+
+            if (config.symbolRate.has_value()) {
+                progressBar(samples, packets, bitErrorRate);
+            } else {
+                progressBar(samples);
+            }
+            lastRefresh = now;
+        }
+    }
+
+    const double seconds = duration<double>(high_resolution_clock::now() - startTime).count();
+    for (auto &channel : channels) {
+        channel->stats.seconds = seconds;
+        channel->stats.lost = channel->decoder.lostSamples();
+        channel->stats.corrupt = channel->decoder.corruptFrames();
+        channel->stats.drift = channel->clock.drift();
+    }
+}
+
+/*
+ * Drains one port and pushes its samples in to the port's ring
+ * readTime is when the read happened (seconds since the start of the capture), everything in this read
+ * arrived by then and the last frame is the one closest to that
+ */
+void readChannel(SerialChannel &channel, double readTime) {
+    if (channel.reader.fill() <= 0) {
+        return;
+    }
+
+    optional<uint64_t> lastDeviceTime = nullopt;
+
+    // Every complete frame that arrived since the last wake-up
+    channel.reader.parse(FRAME_DELIMITER, [&](char *record, size_t length) {
+        FrameView frame;
+        if (!channel.decoder.decode(record, length, frame)) {
+            return;
+        }
+
+        const uint64_t frameTime = channel.clock.unwrap(frame.timestamp);
+        lastDeviceTime = frameTime + (frame.count - 1) * frame.period;
+        if (!channel.clock.ready()) {
+            channel.clock.update(lastDeviceTime.value(), readTime);
         }
-        // Sleep for half the requested polling rate
-        // So we're still checking more often than the values are likely to come in
-        preciseSleep(sleepTime/2);
+
+        for (uint8_t i = 0; i < frame.count; ++i) {
+            const double sampleTime = channel.clock.toHost(frameTime + i * frame.period);
+            // Never block on a slow disk, count the sample as an overrun instead
+            if (channel.samples.push(LogEntry{chrono::duration<double>(sampleTime), frame.sample(i)})) {
+                channel.stats.samples += 1;
+            } else {
+                channel.stats.overruns += 1;
+            }
+        }
+    });
+
+    if (lastDeviceTime.has_value()) {
+        channel.clock.update(lastDeviceTime.value(), readTime);
+    }
+}
+
+/*
+ * <output><suffix>, or <output>_<port><suffix> when recording several ports
+ */
+string getOutputName(const Configuration &config, size_t channel, const string &suffix) {
+    ostringstream name;
+    name << config.output.value_or("photodiode");
+    if (config.arduinoSources.size() > 1) {
+        name << "_" << channel;
     }
-    const auto endTime = high_resolution_clock::now();
+    name << suffix;
+    return name.str();
+}
 
-    return logs;
+/*
+ * VMIN for the requested sample rate, enough bytes for about a millisecond of samples
+ * Falls back to waking up on every byte if the rate is unknown
+ */
+unsigned char getReadThreshold(double pollingRate) {
+    double bytes = pollingRate * BYTES_PER_SAMPLE / WAKEUPS_PER_SECOND;
+    if (bytes < 1) {
+        return 1;
+    }
+    return bytes > 255 ? 255 : static_cast<unsigned char>(bytes);
 }
 
 /*
  * (ADC Reading * System Voltage)/ADC Resolution = Voltage Value
  */
-double getVoltage(int analogVoltage) {
+double getVoltage(double analogVoltage) {
     return (analogVoltage * ADC_VOLTAGE)/ADC_RESOLUTION;
 }
 
@@ -193,32 +428,344 @@ void preciseSleep(double seconds) {
     while ((high_resolution_clock::now() - start).count() / 1e9 < seconds);
 }
 
-void writeLogs(const std::vector<LogEntry> &logs, const Configuration &config) {
-    fstream csvStream;
-    if (config.output.has_value()) {
-        csvStream.open(config.output.value() + ".csv", ios::out);
+/*
+ * Builds the port's processing from the configuration: filters, trigger and demodulator
+ * Packets are decoded on the writer thread, acquisition only reads the counters for the progress line.
+ * Returns false (after saying why) if the configuration is invalid.
+ */
+bool setupChannel(SerialChannel &channel, const Configuration &config, size_t index) {
+    // The matched filter needs to know the rate after any decimators in front of it
+    double sampleRate = config.pollingRate;
+    for (const string &spec : config.filters) {
+        unique_ptr<BlockFilter> filter = makeFilter(spec, sampleRate, config.symbolRate);
+        if (!filter) {
+            return false;
+        }
+        channel.filters.push_back(std::move(filter));
+    }
+
+    if (config.trigger.has_value()) {
+        channel.trigger = makeTrigger(config.trigger.value(), config.triggerWindow, config.preTrigger);
+        if (!channel.trigger) {
+            return false;
+        }
+        if (config.trigger.value() == "barker" && !config.symbolRate.has_value()) {
+            printf("The barker trigger needs the symbol rate\n");
+            return false;
+        }
+    }
+
+    if (config.ackTarget.has_value()) {
+        const string &target = config.ackTarget.value();
+        const size_t colon = target.rfind(':');
+        if (!config.symbolRate.has_value() || !config.sequenced) {
+            printf("Acknowledging packets needs the symbol rate and sequence numbers (-r and -a)\n");
+            return false;
+        }
+        if (colon == string::npos) {
+            printf("The feedback channel has to be <host>:<port>: %s\n", target.c_str());
+            return false;
+        }
+        channel.acks = make_unique<AckSender>(target.substr(0, colon), atoi(target.c_str() + colon + 1));
+        if (!channel.acks->isOpen()) {
+            printf("Unable to open the feedback channel to %s\n", target.c_str());
+            return false;
+        }
+    }
+
+    if (config.symbolRate.has_value()) {
+        channel.packetStream.open(getOutputName(config, index, "_packets.csv"), ios::out);
+        channel.packetStream << "time" << "," << "sequence" << "," << "payload" << "," << "parity" << "\n";
+        channel.demodulator = make_unique<Demodulator>(config.symbolRate.value(), config.sequenced,
+                                                       [&channel](const DecodedPacket &packet) {
+                                                           writePacket(channel.packetStream, packet);
+                                                           if (channel.acks) {
+                                                               channel.acks->acknowledge(packet);
+                                                           }
+                                                           if (channel.trigger) {
+                                                               channel.trigger->trailer(packet.end);
+                                                           }
+                                                       });
+        if (channel.trigger) {
+            channel.demodulator->setHeaderCallback([&channel](double time) {
+                channel.trigger->header(time);
+            });
+        }
+    }
+
+    return true;
+}
+
+LogWriter::LogWriter(const string &fileName, bool binary) : binary(binary) {
+    if (binary) {
+        capture = make_unique<CaptureWriter>(fileName, ADC_VOLTAGE, ADC_RESOLUTION);
+    } else {
+        csvStream.open(fileName, ios::out);
+        csvStream << "deltaTime" << "," << "analogValue" << "," << "voltage" << "\n";
+    }
+}
+
+/*
+ * Writer thread
+ * Drains the ring in blocks of up to WRITE_BLOCK_SIZE samples and flushes the file after every block,
+ * so memory use stays constant however long the capture runs and a crash loses at most one block.
+ * Returns once acquisition is done and the ring is empty.
+ */
+void writeLogs(SerialChannel &channel, const string &fileName, bool binary, const atomic<bool> &acquisitionDone) {
+    LogWriter writer(fileName, binary);
+
+    vector<LogEntry> block(WRITE_BLOCK_SIZE);
+    vector<double> times(WRITE_BLOCK_SIZE);
+    vector<double> values(WRITE_BLOCK_SIZE);
+    while (true) {
+        // Checked before draining so nothing pushed before the flag was set can be missed
+        bool finished = acquisitionDone.load();
+        size_t count = channel.samples.pop(block.data(), block.size());
+
+        for (size_t i = 0; i < count; ++i) {
+            times[i] = block[i].deltaTime.count();
+            values[i] = block[i].analogValue;
+        }
+        processBlock(channel, writer, times.data(), values.data(), count);
+
+        if (count < block.size()) {
+            if (finished) {
+                break;
+            }
+            // Let a block's worth of samples build up
+            this_thread::sleep_for(chrono::milliseconds(WRITER_IDLE_MS));
+        }
+    }
+}
+
+/*
+ * The writer's pipeline, the same for live data and replays
+ * Each block goes through the port's filters first (decimators shrink it), then every sample left goes through
+ * the demodulator when there is one and is written.
+ * A compressed capture holds the raw readings instead, block for block, and the filters only feed the demodulator.
+ * With a trigger only the samples it keeps are written, everything is still demodulated first so the barker
+ * trigger knows about the block's packets before it gates it.
+ * The time spent in every stage is added up in the channel's stageTimes.
+ */
+void processBlock(SerialChannel &channel, LogWriter &writer, double *times, double *values, size_t count) {
+    using namespace chrono;
+
+    if (count == 0) {
+        return;
+    }
+
+    StageTimes &stageTimes = channel.stageTimes;
+    auto stageStart = steady_clock::now();
+    const auto endStage = [&stageStart](double &total) {
+        auto now = steady_clock::now();
+        total += duration<double>(now - stageStart).count();
+        stageStart = now;
+    };
+
+    if (writer.binary) {
+        writer.rawTimes.assign(times, times + count);
+        writer.rawValues.assign(values, values + count);
+    }
+
+    size_t filtered = count;
+    for (auto &filter : channel.filters) {
+        filtered = filter->process(times, values, filtered);
+    }
+    stageTimes.filterSamples += count;
+    endStage(stageTimes.filter);
+
+    if (channel.demodulator) {
+        for (size_t i = 0; i < filtered; ++i) {
+            channel.demodulator->process(values[i], times[i]);
+        }
+    }
+    stageTimes.demodulateSamples += filtered;
+    endStage(stageTimes.demodulate);
+
+    // What gets written, the raw readings for a compressed capture and the filtered ones for the CSV
+    const double *outTimes = writer.binary ? writer.rawTimes.data() : times;
+    const double *outValues = writer.binary ? writer.rawValues.data() : values;
+    size_t outCount = writer.binary ? count : filtered;
+    if (channel.trigger) {
+        stageTimes.triggerSamples += outCount;
+        writer.keptTimes.clear();
+        writer.keptValues.clear();
+        channel.trigger->process(outTimes, outValues, outCount, writer.keptTimes, writer.keptValues);
+        outTimes = writer.keptTimes.data();
+        outValues = writer.keptValues.data();
+        outCount = writer.keptTimes.size();
+    }
+    endStage(stageTimes.trigger);
+
+    if (outCount > 0) {
+        if (writer.binary) {
+            writer.capture->write(outTimes, outValues, outCount);
+            writer.capture->flush();
+        } else {
+            for (size_t i = 0; i < outCount; ++i) {
+                writer.csvStream << outTimes[i] << "," << outValues[i] << "," << getVoltage(outValues[i]) << "\n";
+            }
+            writer.csvStream.flush();
+        }
+    }
+    stageTimes.writeSamples += outCount;
+    endStage(stageTimes.write);
+}
+
+/*
+ * Offline run of a recorded capture through processBlock, as fast as it can go
+ * The sample rate is worked out from the capture if it wasn't given, the output defaults to <capture>_replay
+ * so the capture itself is never overwritten.
+ */
+int replayCapture(const Configuration &config) {
+    using namespace chrono;
+
+    const string &input = config.replay.value();
+    const bool compressed = input.size() > 4 && input.compare(input.size() - 4, 4, ".vlc") == 0;
+
+    Configuration replayConfig = config;
+    replayConfig.arduinoSources = {input};
+    if (!replayConfig.output.has_value()) {
+        replayConfig.output = input.substr(0, input.rfind('.')) + "_replay";
+    }
+
+    unique_ptr<CaptureReader> reader = nullptr;
+    ifstream csvStream;
+    if (compressed) {
+        reader = make_unique<CaptureReader>(input);
+        if (!reader->isOpen()) {
+            printf("%s is not a capture file\n", input.c_str());
+            return -1;
+        }
     } else {
-        ostringstream csvName;
-        // TODO: Put in the actual default name
-        csvName << "photodiode_";
+        csvStream.open(input, ios::in);
+        string header;
+        if (!getline(csvStream, header)) {
+            printf("Unable to read %s\n", input.c_str());
+            return -1;
+        }
+    }
+
+    // Reads the next block of the capture, returns the number of samples in it
+    size_t nextBlock = 0;
+    vector<uint16_t> readings;
+    vector<double> times(WRITE_BLOCK_SIZE);
+    vector<double> values(WRITE_BLOCK_SIZE);
+    const auto readBlock = [&]() -> size_t {
+        if (!compressed) {
+            return readCsvBlock(csvStream, times, values, WRITE_BLOCK_SIZE);
+        }
+        while (nextBlock < reader->blocks() && !reader->readBlock(nextBlock, times, readings)) {
+            printf("Block %zu of the capture is corrupt, skipping it\n", nextBlock++);
+        }
+        if (nextBlock == reader->blocks()) {
+            return 0;
+        }
+        ++nextBlock;
+        values.assign(readings.begin(), readings.end());
+        return times.size();
+    };
+
+    auto readStart = steady_clock::now();
+    size_t count = readBlock();
+    double readSeconds = duration<double>(steady_clock::now() - readStart).count();
+
+    if (replayConfig.pollingRate <= 0 && count > 1) {
+        replayConfig.pollingRate = (count - 1) / (times[count - 1] - times[0]);
+    }
 
-        csvStream.open(csvName.str(), ios::out);
+    SerialChannel channel(input, 0);
+    if (!setupChannel(channel, replayConfig, 0)) {
+        return -1;
     }
+    LogWriter writer(getOutputName(replayConfig, 0, replayConfig.binary ? ".vlc" : ".csv"), replayConfig.binary);
 
-    csvStream << "deltaTime" << "," << "analogValue" << "," << "voltage" << "\n";
+    uint64_t samples = 0;
+    const auto start = steady_clock::now();
+    while (count > 0) {
+        samples += count;
+        processBlock(channel, writer, times.data(), values.data(), count);
 
-    // frameAverage is of type double[4], we need to destructure it
-    for (const LogEntry &entry : logs) {
-        csvStream << entry.deltaTime.count() << "," << entry.analogValue << "," << entry.deducedVoltage << "\n";
+        // Blocks from a compressed capture vary in size
+        times.resize(WRITE_BLOCK_SIZE);
+        values.resize(WRITE_BLOCK_SIZE);
+
+        readStart = steady_clock::now();
+        count = readBlock();
+        readSeconds += duration<double>(steady_clock::now() - readStart).count();
+    }
+    const double seconds = duration<double>(steady_clock::now() - start).count();
+
+    const StageTimes &stageTimes = channel.stageTimes;
+    const auto rate = [](uint64_t stageSamples, double stageSeconds) {
+        return stageSeconds > 0 ? stageSamples / stageSeconds : 0.0;
+    };
+    printf("Replayed %lu samples in %.2f s (%.0f samples/s)\n", (unsigned long) samples, seconds,
+           rate(samples, seconds));
+    printf("Read:\t\t%.0f samples/s\n", rate(samples, readSeconds));
+    if (!channel.filters.empty()) {
+        printf("Filters:\t%.0f samples/s\n", rate(stageTimes.filterSamples, stageTimes.filter));
+    }
+    if (channel.demodulator) {
+        printf("Demodulator:\t%.0f samples/s\n", rate(stageTimes.demodulateSamples, stageTimes.demodulate));
+    }
+    if (channel.trigger) {
+        printf("Trigger:\t%.0f samples/s\n", rate(stageTimes.triggerSamples, stageTimes.trigger));
+    }
+    printf("Write:\t\t%.0f samples/s\n", rate(stageTimes.writeSamples, stageTimes.write));
+    if (channel.demodulator) {
+        printf("Packets: %lu\tParity errors: %lu\tBER: %.2e\n", (unsigned long) channel.demodulator->packets(),
+               (unsigned long) channel.demodulator->parityErrors(), channel.demodulator->bitErrorRate());
+    }
+    if (channel.trigger) {
+        printf("Triggers: %lu\tKept: %.1f%%\n", (unsigned long) channel.trigger->triggers(),
+               100 * channel.trigger->dutyCycle());
+    }
+
+    return 0;
+}
+
+/*
+ * Reads up to maxCount rows of deltaTime,analogValue[,voltage] in to times and values
+ */
+size_t readCsvBlock(ifstream &csvStream, vector<double> &times, vector<double> &values, size_t maxCount) {
+    size_t count = 0;
+    string line;
+    while (count < maxCount && getline(csvStream, line)) {
+        char *end;
+        times[count] = strtod(line.c_str(), &end);
+        if (*end != ',') {
+            continue;
+        }
+        values[count] = strtod(end + 1, nullptr);
+        ++count;
     }
+    return count;
+}
 
-    csvStream.close();
+/*
+ * One row per decoded packet, the payload is quoted since it is whatever text the transmitter sent
+ */
+void writePacket(ofstream &packetStream, const DecodedPacket &packet) {
+    packetStream << packet.time << ",";
+    if (packet.sequence.has_value()) {
+        packetStream << (int) packet.sequence.value();
+    }
+    packetStream << ",\"";
+    for (char c : packet.payload) {
+        if (c == '"') {
+            packetStream << '"';
+        }
+        packetStream << c;
+    }
+    packetStream << "\"," << (packet.parityOk ? "ok" : "error") << "\n";
+    packetStream.flush();
 }
 
-int serialErrorHandler(int serialErr, const Configuration &appConfig) {
+int serialErrorHandler(int serialErr, const string &source) {
     switch (serialErr) {
         case -1:
-            printf("Device %s not found\n", appConfig.arduinoSource.c_str());
+            printf("Device %s not found\n", source.c_str());
             return -1;
         case -2:
             printf("Error while opening device\n");
@@ -259,8 +806,9 @@ void showUsage() {
 Configuration getTestConfig() {
     Configuration testConfig{};
 
-    testConfig.arduinoSource = R"(/dev/ttyUSB0)";
+    testConfig.arduinoSources = {R"(/dev/ttyUSB0)"};
     testConfig.pollingRate = 10'000;
+    testConfig.baudRate = 115'200;
     testConfig.output = "testReceiver";
 
     return testConfig;
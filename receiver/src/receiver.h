@@ -10,7 +10,18 @@
 #include <chrono>
 #include <cmath>
 
+#include <atomic>
+
 #include "serialib.h"
+#include "RingBuffer.h"
+#include "SerialReader.h"
+#include "FrameDecoder.h"
+#include "ClockSync.h"
+#include "Demodulator.h"
+#include "Filters.h"
+#include "CaptureFile.h"
+#include "Trigger.h"
+#include "AckSender.h"
 
 #ifndef RECEIVER_RECEIVER_H
 #define RECEIVER_RECEIVER_H
@@ -20,17 +31,103 @@ using namespace std;
 struct Configuration {
     // This should be separated into private variables and public accessor methods but
     // I am becoming a little lazy
-    string arduinoSource{};
+    // One per -s, every port is recorded on the same host time base
+    vector<string> arduinoSources{};
     double pollingRate{};
+    unsigned int baudRate = 115200;
     optional<string> output{};
+    // Transmitter bit rate, packets are only decoded online when it is known
+    optional<double> symbolRate{};
+    // Packets carry the ARQ sequence number (transmitter run with --arq)
+    bool sequenced = false;
+    // host:port of the transmitter's feedback channel, decoded packets are acknowledged to it
+    optional<string> ackTarget{};
+    // Filter specs in the order they're applied (refer to makeFilter)
+    vector<string> filters{};
+    // Write a compressed capture (refer to CaptureFile.h) instead of the CSV
+    bool binary = false;
+    // Only keep the samples around transmissions (refer to makeTrigger)
+    optional<string> trigger{};
+    // Seconds kept after the last trigger and before the first
+    double triggerWindow = 1.0;
+    double preTrigger = 0.5;
+    // Recorded capture (CSV or compressed) to run through the pipeline instead of the serial ports
+    optional<string> replay{};
 };
 
+// Kept compact since the ring holds a lot of these, the voltage is derived when it's written out
+// deltaTime is the sample's device time mapped on to the host clock
 struct LogEntry {
     chrono::duration<double> deltaTime{};
-    double deducedVoltage{};
     int analogValue{};
 };
 
+struct CaptureStats {
+    uint64_t samples{};
+    // Samples missing from the sequence numbers of the frames
+    uint64_t lost{};
+    // Frames that failed the length or CRC check
+    uint64_t corrupt{};
+    // Samples dropped because the ring was full
+    uint64_t overruns{};
+    // Device clock relative to the host clock, parts per million
+    double drift{};
+    // Time spent acquiring
+    double seconds{};
+};
+
+// Time spent in each stage of the writer's pipeline and the samples that went in to it
+struct StageTimes {
+    double filter{};
+    double demodulate{};
+    double trigger{};
+    double write{};
+    uint64_t filterSamples{};
+    uint64_t demodulateSamples{};
+    uint64_t triggerSamples{};
+    uint64_t writeSamples{};
+};
+
+/*
+ * Everything kept per serial port
+ * Each Arduino has its own micros() counter, so every port gets its own ClockSync mapping it on to the
+ * shared host clock, and its own ring and writer thread so one slow file can't hold up the other ports.
+ */
+struct SerialChannel {
+    string source;
+    serialib port{};
+    SerialReader reader;
+    FrameDecoder decoder{};
+    ClockSync clock{};
+    RingBuffer<LogEntry> samples;
+    CaptureStats stats{};
+    ofstream packetStream{};
+    unique_ptr<Demodulator> demodulator = nullptr;
+    // Run on the writer thread, before the samples are written and demodulated
+    vector<unique_ptr<BlockFilter>> filters{};
+    unique_ptr<Trigger> trigger = nullptr;
+    unique_ptr<AckSender> acks = nullptr;
+    StageTimes stageTimes{};
+    thread writer{};
+
+    SerialChannel(string source, size_t ringCapacity) : source(std::move(source)), reader(port),
+                                                          samples(ringCapacity) {}
+};
+
+// Output end of the pipeline, either the CSV or a compressed capture
+struct LogWriter {
+    bool binary;
+    fstream csvStream{};
+    unique_ptr<CaptureWriter> capture = nullptr;
+    // Raw readings kept for the compressed capture while the filters work on the block
+    vector<double> rawTimes{};
+    vector<double> rawValues{};
+    vector<double> keptTimes{};
+    vector<double> keptValues{};
+
+    LogWriter(const string &fileName, bool binary);
+};
+
 enum PosArg {
     NO_ARG,
     OPT_ARG,
@@ -46,15 +143,31 @@ struct CLOption {
 
 void parseArgs(int argc, char *argv[], Configuration &config);
 
-void writeLogs(const std::vector<LogEntry> &logs, const Configuration &config);
+bool setupChannel(SerialChannel &channel, const Configuration &config, size_t index);
+
+void writeLogs(SerialChannel &channel, const string &fileName, bool binary, const atomic<bool> &acquisitionDone);
+
+void processBlock(SerialChannel &channel, LogWriter &writer, double *times, double *values, size_t count);
+
+int replayCapture(const Configuration &config);
+
+size_t readCsvBlock(ifstream &csvStream, vector<double> &times, vector<double> &values, size_t maxCount);
+
+void writePacket(ofstream &packetStream, const DecodedPacket &packet);
+
+void readSerialPorts(vector<unique_ptr<SerialChannel>> &channels, const Configuration &config);
+
+void readChannel(SerialChannel &channel, double readTime);
+
+string getOutputName(const Configuration &config, size_t channel, const string &suffix);
 
-vector<LogEntry> readSerialPort(serialib &serialPort, const Configuration &config);
+double getVoltage(double analogVoltage);
 
-double getVoltage(int analogVoltage);
+unsigned char getReadThreshold(double pollingRate);
 
 void preciseSleep(double seconds);
 
-int serialErrorHandler(int serialErr, const Configuration &appConfig);
+int serialErrorHandler(int serialErr, const string &source);
 
 void showUsage();
 
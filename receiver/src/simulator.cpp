@@ -0,0 +1,252 @@
+/*
+ * Host-side stand-in for the arduino_receiver sketch
+ * Produces the same binary frames as the sketch (it uses the same FrameEncoder) from a synthetic
+ * on-off keyed photodiode signal, paced in real time, so the receiver can be run without a board:
+ *  mkfifo /tmp/arduino && ./arduino_simulator -o /tmp/arduino & ./receiver -s /tmp/arduino
+ * or behind a pseudo-terminal, which goes through the same tty layer as the USB serial port:
+ *  ./arduino_simulator -p & ./receiver -s <printed /dev/pts/N>
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+#include "FrameProtocol.h"
+
+using namespace std;
+
+// ADC readings of the LED being on and off
+constexpr uint16_t SIGNAL_HIGH = 800;
+constexpr uint16_t SIGNAL_LOW = 200;
+constexpr int ADC_MAX = 1023;
+// The frame header holds the sample period in whole microseconds, up to 0xFFFF
+constexpr double MIN_SAMPLE_RATE = 1e6 / 0xFFFF;
+constexpr double MAX_SAMPLE_RATE = 1e6;
+
+struct SimulatorConfig {
+    string output{};
+    double sampleRate = 10'000;
+    double signalFrequency = 25;
+    double duration = 0;
+    // Standard deviation of the gaussian noise added to every reading, in ADC counts
+    double noise = 0;
+    bool pty = false;
+    // Send this text as the transmitter's packets instead of random bits
+    string message{};
+    // Seconds of darkness between repeats of the message
+    double gap = 1;
+};
+
+void showUsage() {
+    printf("./arduino_simulator -o <output> -p -r <sample_rate> -f <signal_frequency> -m <message> -g <gap> -n <noise> -d <duration>\n");
+    printf("-o or --output\t: File, FIFO or tty to write the frames to (stdout if not given)\n");
+    printf("-p or --pty\t: Create a pseudo-terminal and write to it instead, its path is printed on start\n");
+    printf("-r or --rate\t: Samples per second (10000 by default)\n");
+    printf("-f or --frequency\t: Bit rate of the simulated on-off keyed signal (25 by default)\n");
+    printf("-m or --message\t: Send the text as the transmitter's packets, over and over, instead of random bits\n");
+    printf("-g or --gap\t: Seconds of darkness between repeats of the message (1 by default)\n");
+    printf("-n or --noise\t: Standard deviation of the noise added to the signal in ADC counts (0 by default)\n");
+    printf("-d or --duration\t: Seconds to run for, runs until killed if not given\n");
+}
+
+void parseArgs(int argc, char *argv[], SimulatorConfig &config) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if ((arg == "-h") || (arg == "--help")) {
+            showUsage();
+            exit(0);
+        } else if (((arg == "-o") || (arg == "--output")) && i + 1 < argc) {
+            config.output = argv[++i];
+        } else if (((arg == "-r") || (arg == "--rate")) && i + 1 < argc) {
+            config.sampleRate = strtod(argv[++i], nullptr);
+        } else if (((arg == "-f") || (arg == "--frequency")) && i + 1 < argc) {
+            config.signalFrequency = strtod(argv[++i], nullptr);
+        } else if ((arg == "-p") || (arg == "--pty")) {
+            config.pty = true;
+        } else if (((arg == "-m") || (arg == "--message")) && i + 1 < argc) {
+            config.message = argv[++i];
+        } else if (((arg == "-g") || (arg == "--gap")) && i + 1 < argc) {
+            config.gap = strtod(argv[++i], nullptr);
+        } else if (((arg == "-n") || (arg == "--noise")) && i + 1 < argc) {
+            config.noise = strtod(argv[++i], nullptr);
+        } else if (((arg == "-d") || (arg == "--duration")) && i + 1 < argc) {
+            config.duration = strtod(argv[++i], nullptr);
+        } else {
+            printf("Unknown Option %s\n", arg.c_str());
+            showUsage();
+            exit(-1);
+        }
+    }
+
+    // Written so NaN fails them too
+    if (!(config.sampleRate >= MIN_SAMPLE_RATE && config.sampleRate <= MAX_SAMPLE_RATE)) {
+        printf("The sample rate has to be between %.2f and %.0f samples per second\n", MIN_SAMPLE_RATE,
+               MAX_SAMPLE_RATE);
+        exit(-1);
+    }
+    if (!(config.signalFrequency > 0 && config.signalFrequency <= config.sampleRate)) {
+        printf("The bit rate has to be above 0 and can't be more than the sample rate\n");
+        exit(-1);
+    }
+    if (!(config.gap >= 0)) {
+        printf("The gap can't be negative\n");
+        exit(-1);
+    }
+}
+
+/*
+ * Opens a pseudo-terminal and returns the master side, the slave's path is written to slavePath
+ * The slave is put in raw mode and kept open (slaveFd) so the line discipline never mangles the frames
+ * and writes don't fail while the receiver isn't connected yet.
+ * The master is non-blocking: like a UART nobody is reading, whatever doesn't fit is dropped.
+ */
+int openPty(string &slavePath, int &slaveFd) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        return -1;
+    }
+
+    slavePath = ptsname(master);
+    slaveFd = open(slavePath.c_str(), O_RDWR | O_NOCTTY);
+    if (slaveFd < 0) {
+        close(master);
+        return -1;
+    }
+
+    termios options{};
+    tcgetattr(slaveFd, &options);
+    cfmakeraw(&options);
+    tcsetattr(slaveFd, TCSANOW, &options);
+
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    return master;
+}
+
+/*
+ * The message as the transmitter sends it (refer to transmitter/src/Packet.cpp), 8 characters to a packet:
+ * Barker-7 header, parity bit, payload MSB first and an all-zero terminator, followed by gap bits of darkness
+ */
+vector<int> getTransmission(const string &message, size_t gapBits) {
+    vector<int> bits;
+    for (size_t start = 0; start < message.size(); start += 8) {
+        const string payload = message.substr(start, 8);
+        int parity = 0;
+        for (char c : payload) {
+            parity ^= c & 0x01;
+        }
+
+        bits.insert(bits.end(), {1, 1, 1, 0, 0, 1, 0});
+        bits.push_back(parity);
+        for (char c : payload) {
+            for (int j = 7; j >= 0; --j) {
+                bits.push_back((c >> j) & 0x01);
+            }
+        }
+        bits.insert(bits.end(), 8, 0);
+    }
+    bits.insert(bits.end(), gapBits, 0);
+    return bits;
+}
+
+int main(int argc, char *argv[]) {
+    using namespace chrono;
+
+    SimulatorConfig config{};
+    parseArgs(argc, argv, config);
+
+    int fd;
+    int slaveFd = -1;
+    if (config.pty) {
+        string slavePath;
+        fd = openPty(slavePath, slaveFd);
+        if (fd < 0) {
+            printf("Unable to create a pseudo-terminal\n");
+            return -1;
+        }
+        printf("PTY: %s\n", slavePath.c_str());
+        fflush(stdout);
+    } else {
+        fd = config.output.empty() ? STDOUT_FILENO : open(config.output.c_str(), O_WRONLY | O_NOCTTY);
+        if (fd < 0) {
+            printf("Unable to open %s\n", config.output.c_str());
+            return -1;
+        }
+    }
+
+    // Kept exact, every sample's time comes from its index so a period that isn't a whole microsecond doesn't drift
+    const double period = 1e6 / config.sampleRate;
+    const auto nominalPeriod = static_cast<uint16_t>(std::lround(period));
+    const auto samplesPerBit = static_cast<uint64_t>(config.sampleRate / config.signalFrequency);
+    const auto totalSamples = static_cast<uint64_t>(config.duration * config.sampleRate);
+
+    FrameEncoder encoder;
+    uint8_t frameBuffer[FRAME_MAX_ENCODED_SIZE];
+    mt19937 generator(1);
+    normal_distribution<double> noise(0, config.noise);
+    int bit = 0;
+    const vector<int> transmission = getTransmission(
+            config.message, static_cast<size_t>(config.gap * config.signalFrequency));
+    uint64_t frames = 0;
+    uint64_t droppedFrames = 0;
+
+    const auto start = steady_clock::now();
+    for (uint64_t i = 0; totalSamples == 0 || i < totalSamples; ++i) {
+        if (i % samplesPerBit == 0) {
+            if (config.message.empty()) {
+                bit = static_cast<int>(generator() % 2);
+            } else {
+                bit = transmission[(i / samplesPerBit) % transmission.size()];
+            }
+        }
+
+        double reading = bit ? SIGNAL_HIGH : SIGNAL_LOW;
+        if (config.noise > 0) {
+            reading += noise(generator);
+        }
+        reading = reading < 0 ? 0 : (reading > ADC_MAX ? ADC_MAX : reading);
+
+        // The simulated micros() wraps around just like the real one
+        auto micros = static_cast<uint32_t>(static_cast<uint64_t>(i * period));
+        if (encoder.add(static_cast<uint16_t>(reading), micros, nominalPeriod)) {
+            uint16_t length = encoder.finish(frameBuffer);
+            ssize_t written = write(fd, frameBuffer, length);
+            frames += 1;
+            if (written != length) {
+                if (!config.pty || (written < 0 && errno != EAGAIN)) {
+                    break;
+                }
+                // Partially written frames fail the receiver's CRC, they're lost either way
+                droppedFrames += 1;
+            }
+            // Keep to the device's pace
+            this_thread::sleep_until(start + microseconds(static_cast<uint64_t>((i + 1) * period)));
+        }
+    }
+
+    // Partial last frame
+    uint16_t length = encoder.finish(frameBuffer);
+    if (length > 0 && write(fd, frameBuffer, length) != length) {
+        printf("Unable to write the last frame\n");
+    }
+
+    if (config.pty) {
+        printf("Frames: %lu\tDropped frames: %lu\n", (unsigned long) frames, (unsigned long) droppedFrames);
+        // Give the receiver time to drain the pty before its slave side disappears
+        this_thread::sleep_for(milliseconds(100));
+        close(slaveFd);
+    }
+
+    if (fd != STDOUT_FILENO) {
+        close(fd);
+    }
+    return 0;
+}
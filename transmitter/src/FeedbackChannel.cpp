@@ -0,0 +1,98 @@
+#include "FeedbackChannel.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+FeedbackChannel::FeedbackChannel(int port) {
+    m_socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (m_socket < 0) {
+        return;
+    }
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+
+    if (bind(m_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        close(m_socket);
+        m_socket = -1;
+        return;
+    }
+
+    fcntl(m_socket, F_SETFL, fcntl(m_socket, F_GETFL) | O_NONBLOCK);
+}
+
+FeedbackChannel::FeedbackChannel(const std::string &host, int port) {
+    m_socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (m_socket < 0) {
+        return;
+    }
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1 ||
+        connect(m_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        close(m_socket);
+        m_socket = -1;
+        return;
+    }
+
+    fcntl(m_socket, F_SETFL, fcntl(m_socket, F_GETFL) | O_NONBLOCK);
+}
+
+bool FeedbackChannel::isOpen() const {
+    return m_socket >= 0;
+}
+
+bool FeedbackChannel::send(const AckFrame &frame) const {
+    unsigned char buffer[ACK_FRAME_SIZE];
+    serialise(frame, buffer);
+
+    return ::send(m_socket, buffer, ACK_FRAME_SIZE, 0) == ACK_FRAME_SIZE;
+}
+
+std::optional<AckFrame> FeedbackChannel::receive() const {
+    unsigned char buffer[ACK_FRAME_SIZE];
+
+    // Anything that isn't exactly one frame is discarded
+    ssize_t received;
+    while ((received = recv(m_socket, buffer, ACK_FRAME_SIZE, 0)) >= 0) {
+        if (received == ACK_FRAME_SIZE) {
+            return deserialise(buffer);
+        }
+    }
+
+    return std::nullopt;
+}
+
+// Bitmaps are sent big endian
+void FeedbackChannel::serialise(const AckFrame &frame, unsigned char *buffer) {
+    buffer[0] = frame.base;
+    for (int i = 0; i < 4; ++i) {
+        buffer[1 + i] = (frame.received >> (24 - 8 * i)) & 0xFF;
+        buffer[5 + i] = (frame.lost >> (24 - 8 * i)) & 0xFF;
+    }
+}
+
+AckFrame FeedbackChannel::deserialise(const unsigned char *buffer) {
+    AckFrame frame{};
+    frame.base = buffer[0];
+    for (int i = 0; i < 4; ++i) {
+        frame.received = (frame.received << 8) | buffer[1 + i];
+        frame.lost = (frame.lost << 8) | buffer[5 + i];
+    }
+
+    return frame;
+}
+
+FeedbackChannel::~FeedbackChannel() {
+    if (m_socket >= 0) {
+        close(m_socket);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef TRANSMITTER_FEEDBACKCHANNEL_H
+#define TRANSMITTER_FEEDBACKCHANNEL_H
+
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+
+// Size of an AckFrame on the wire: base (1) + received bitmap (4) + lost bitmap (4)
+#define ACK_FRAME_SIZE 9
+
+// Selective repeat acknowledgement sent by the receiver
+// Bit i of either bitmap refers to sequence number (base + i) mod 256
+struct AckFrame {
+    uint8_t base{};
+    // Packets that arrived with a valid parity bit
+    uint32_t received{};
+    // Packets the receiver knows it lost (a later sequence number arrived first or the parity failed)
+    uint32_t lost{};
+};
+
+/*
+ * Local feedback channel between the receiver and the transmitter
+ * Both ends are plain UDP sockets, the transmitter binds to the port and the receiver sends to it
+ * All calls are non-blocking so polling it between packets does not stall the transmission
+ */
+class FeedbackChannel {
+private:
+    int m_socket;
+
+public:
+    virtual ~FeedbackChannel();
+
+    // Binds to the local port (transmitter side)
+    explicit FeedbackChannel(int port);
+
+    // Connects to host:port (receiver side)
+    FeedbackChannel(const std::string &host, int port);
+
+    bool isOpen() const;
+
+    bool send(const AckFrame &frame) const;
+
+    // Returns the next pending acknowledgement or nullopt if nothing has arrived
+    std::optional<AckFrame> receive() const;
+
+    static void serialise(const AckFrame &frame, unsigned char *buffer);
+
+    static AckFrame deserialise(const unsigned char *buffer);
+};
+
+
+#endif //TRANSMITTER_FEEDBACKCHANNEL_H
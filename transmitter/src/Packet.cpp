@@ -13,6 +13,10 @@ Packet::Packet(std::string &payload) {
     m_parityBit = generateParityBit(payload);
 }
 
+Packet::Packet(std::string &payload, uint8_t sequence) : Packet(payload) {
+    m_sequence = sequence;
+}
+
 unsigned char Packet::generateParityBit(const std::string &payload) {
     uint8_t parityStorage = 0;
 
@@ -35,6 +39,13 @@ std::vector<int> Packet::getTransmission() {
     // append parity
     transmission.push_back(m_parityBit);
 
+    // append the sequence number (ARQ only)
+    if (m_sequence.has_value()) {
+        for (int j = 7; j >= 0; --j) {
+            transmission.push_back((m_sequence.value() >> j) & 0x01);
+        }
+    }
+
     // inserts all the transmission bits
     for (int i = 0; i < m_payloadFill; ++i) {
         for (int j = 7; j >= 0; --j) {
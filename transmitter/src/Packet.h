@@ -7,9 +7,11 @@
 
 #pragma once
 #include <cstdlib>
+#include <cstdint>
 #include <cstring>
 #include <vector>
 #include <string>
+#include <optional>
 
 #define PAYLOAD_SIZE 8
 
@@ -22,12 +24,16 @@ private:
     unsigned char* m_payload;
     int m_payloadFill;
     unsigned char m_parityBit;
+    // Only set for ARQ packets, sent as 8 bits straight after the parity bit
+    std::optional<uint8_t> m_sequence;
 
 public:
     virtual ~Packet();
 
     explicit Packet(std::string &payload);
 
+    Packet(std::string &payload, uint8_t sequence);
+
     std::vector<int> getTransmission();
 };
 
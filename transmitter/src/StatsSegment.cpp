@@ -0,0 +1,60 @@
+#include "StatsSegment.h"
+
+#include <new>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+StatsSegment::StatsSegment(bool owner) : m_stats(nullptr), m_owner(owner) {
+    int fd = owner ? shm_open(STATS_SEGMENT_NAME, O_CREAT | O_RDWR, 0644)
+                   : shm_open(STATS_SEGMENT_NAME, O_RDONLY, 0);
+    if (fd < 0) {
+        return;
+    }
+
+    if (owner && ftruncate(fd, sizeof(TransmitterStats)) != 0) {
+        close(fd);
+        return;
+    }
+
+    void *mapping = mmap(nullptr, sizeof(TransmitterStats), owner ? PROT_READ | PROT_WRITE : PROT_READ,
+                         MAP_SHARED, fd, 0);
+    // The mapping keeps the segment alive on its own
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return;
+    }
+
+    if (owner) {
+        m_stats = new(mapping) TransmitterStats{};
+        m_stats->magic = STATS_SEGMENT_MAGIC;
+        m_stats->pid.store(getpid(), std::memory_order_relaxed);
+    } else {
+        m_stats = static_cast<TransmitterStats *>(mapping);
+        if (m_stats->magic != STATS_SEGMENT_MAGIC) {
+            munmap(mapping, sizeof(TransmitterStats));
+            m_stats = nullptr;
+        }
+    }
+}
+
+void StatsSegment::unlink() {
+    shm_unlink(STATS_SEGMENT_NAME);
+}
+
+TransmitterStats *StatsSegment::get() const {
+    return m_stats;
+}
+
+StatsSegment::~StatsSegment() {
+    if (m_stats == nullptr) {
+        return;
+    }
+
+    if (m_owner) {
+        // Leaves a zeroed pid behind so readers know the transmitter is gone
+        m_stats->pid.store(0, std::memory_order_relaxed);
+        shm_unlink(STATS_SEGMENT_NAME);
+    }
+    munmap(m_stats, sizeof(TransmitterStats));
+}
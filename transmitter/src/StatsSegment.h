@@ -0,0 +1,52 @@
+#ifndef TRANSMITTER_STATSSEGMENT_H
+#define TRANSMITTER_STATSSEGMENT_H
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Name of the POSIX shared memory object, shows up as /dev/shm/underwatervlc_transmitter
+#define STATS_SEGMENT_NAME "/underwatervlc_transmitter"
+#define STATS_SEGMENT_MAGIC 0x564C4331
+
+/*
+ * Live counters of the transmitter
+ * Only ever written by the transmitter with relaxed atomics, so updating them is a plain store
+ * and readers never block the transmission
+ */
+struct TransmitterStats {
+    uint32_t magic;
+    std::atomic<int32_t> pid;
+    std::atomic<uint64_t> bitsSent;
+    std::atomic<uint64_t> failures;
+    std::atomic<uint64_t> deadlineMisses;
+    // Bits still waiting to be transmitted
+    std::atomic<uint64_t> queueDepth;
+    // Bits per second over the last refresh period
+    std::atomic<double> currentRate;
+};
+
+/*
+ * Maps the TransmitterStats into a shared memory segment
+ * The transmitter creates it and the stat command attaches to it read-only
+ */
+class StatsSegment {
+private:
+    TransmitterStats *m_stats;
+    bool m_owner;
+
+public:
+    virtual ~StatsSegment();
+
+    // Creates (owner = true) or attaches to the segment
+    explicit StatsSegment(bool owner);
+
+    // nullptr if the segment could not be mapped
+    TransmitterStats *get() const;
+
+    // Removes the segment's name without touching the mapping, safe to call from a signal handler
+    static void unlink();
+};
+
+
+#endif //TRANSMITTER_STATSSEGMENT_H
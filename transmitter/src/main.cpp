@@ -12,6 +12,7 @@
 #include "gpiod.h"
 #include "utils.h"
 #include "Packet.h"
+#include "FeedbackChannel.h"
 #include "main.h"
 
 // Function declarations
@@ -26,8 +27,15 @@ void setState(const Configuration &config);
 
 optional<vector<LogEntry>> transmit(const Configuration &config, const vector<int> &transmission);
 
+void transmitBits(gpiod_line *pin, const vector<int> &bits, double frequency, TransmitState &state,
+                  vector<LogEntry> &logs);
+
+void refreshStats(TransmitState &state, chrono::high_resolution_clock::time_point now);
+
 optional<vector<LogEntry>> transmitMessage(const Configuration &config, const string &message);
 
+optional<vector<LogEntry>> transmitReliable(const Configuration &config, const string &message);
+
 void preciseSleep(double seconds);
 
 void generateCSV(const vector<LogEntry> &logs, const Configuration &appConfig);
@@ -52,6 +60,9 @@ int main(int argc, char *argv[]) {
     Configuration appConfig{};
     parseArgs(argc, argv, appConfig);
 
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+
     optional<vector<LogEntry>> logs = vector<LogEntry>();
 
     if (appConfig.type.has_value()) {
@@ -66,8 +77,11 @@ int main(int argc, char *argv[]) {
                 break;
             }
             case MESSAGE: {
-                auto message = appConfig.message.value();
-                logs = transmitMessage(appConfig, appConfig.message.value());
+                if (appConfig.arqPort.has_value()) {
+                    logs = transmitReliable(appConfig, appConfig.message.value());
+                } else {
+                    logs = transmitMessage(appConfig, appConfig.message.value());
+                }
                 break;
             }
             case TEST: {
@@ -109,10 +123,11 @@ void parseArgs(int argc, char **argv, Configuration &config) {
             {"cycles",    required_argument, nullptr, 'c'},
             {"output",    optional_argument, nullptr, 'o'},
             {"test",      no_argument,       nullptr, 't'},
+            {"arq",       required_argument, nullptr, 'a'},
             {nullptr,     no_argument,       nullptr, 0}
     };
     int optionIdx = 0;
-    while ((opt = getopt_long(argc, argv, "hs:r:m:f:c:o:t", long_options, &optionIdx)) != -1) {
+    while ((opt = getopt_long(argc, argv, "hs:r:m:f:c:o:ta:", long_options, &optionIdx)) != -1) {
         switch (opt) {
             case 0:
                 //TODO: No arguments, default config
@@ -159,6 +174,9 @@ void parseArgs(int argc, char **argv, Configuration &config) {
             case 't':
                 config = getTestConfiguration();
                 break;
+            case 'a':
+                config.arqPort = strtol(optarg, nullptr, 10);
+                break;
             default:
                 printf("Unknown option %s with argument %s", long_options[opt].name, optarg);
                 break;
@@ -238,51 +256,91 @@ optional<vector<LogEntry>> transmit(const Configuration &config, const vector<in
     gpiod_line_request_output(pin, "transmitter_out", 0);
 
     const double frequency = config.frequency.value();
-    const auto length = transmission.size() * config.cycles.value();
-    int transmitted = 0, failed = 0;
-    const auto t_0 = chrono::high_resolution_clock::now();
+    StatsSegment statsSegment(true);
+    TransmitState state{};
+    state.stats = statsSegment.get();
+    state.queued = transmission.size() * config.cycles.value();
 
     for (int count = 0; count < config.cycles; ++count) {
-        for (int i: transmission) {
-            auto currentEntry = LogEntry{};
-            auto nextClock = chrono::high_resolution_clock::now();
-
-            int complete = gpiod_line_set_value(pin, i);
-
-            if (complete != 0) {
-                // Transmission failed
-                failed += 1;
-                currentEntry.deltaTime = (chrono::high_resolution_clock::now() - t_0);
-                currentEntry.transmittedBit = nullopt;
-                currentEntry.message = "Bit dropped";
-                logs.push_back(currentEntry);
-            } else {
-                // Manage Logs
-                transmitted += 1;
-                currentEntry.deltaTime = (chrono::high_resolution_clock::now() - t_0);
-                currentEntry.transmittedBit = i;
-                currentEntry.message = nullopt;
-                logs.push_back(currentEntry);
-            }
+        transmitBits(pin, transmission, frequency, state, logs);
+    }
 
-            progressBar(transmitted, failed);
+    printf("Transmitted: %i\t Failed: %i\n", state.transmitted, state.failed);
+    gpiod_line_set_value(pin, 0);
 
-            auto transmitClock = chrono::high_resolution_clock::now();
+    // Clean Up
+    gpioCleanUp(chip, pin);
 
-            double sleepTime = frequency - ((transmitClock - nextClock).count() / 1e9);
+    return logs;
+}
+
+// Drives the already requested pin through the bits, one bit per period
+void transmitBits(gpiod_line *pin, const vector<int> &bits, const double frequency, TransmitState &state,
+                  vector<LogEntry> &logs) {
+    for (int i: bits) {
+        auto currentEntry = LogEntry{};
+        auto nextClock = chrono::high_resolution_clock::now();
+
+        int complete = gpiod_line_set_value(pin, i);
+
+        if (complete != 0) {
+            // Transmission failed
+            state.failed += 1;
+            currentEntry.deltaTime = (chrono::high_resolution_clock::now() - state.t_0);
+            currentEntry.transmittedBit = nullopt;
+            currentEntry.message = "Bit dropped";
+            logs.push_back(currentEntry);
+        } else {
+            // Manage Logs
+            state.transmitted += 1;
+            currentEntry.deltaTime = (chrono::high_resolution_clock::now() - state.t_0);
+            currentEntry.transmittedBit = i;
+            currentEntry.message = nullopt;
+            logs.push_back(currentEntry);
+        }
+
+        auto transmitClock = chrono::high_resolution_clock::now();
+
+        double sleepTime = frequency - ((transmitClock - nextClock).count() / 1e9);
+
+        if (state.queued > 0) {
+            state.queued -= 1;
+        }
+        if (sleepTime < 0) {
+            // The bit took longer than its period
+            state.missed += 1;
+        }
 
-            // sleep for dT using a spinLock
-            preciseSleep(sleepTime);
+        // Plain stores, nothing in here may make a syscall
+        if (state.stats != nullptr) {
+            state.stats->bitsSent.store(state.transmitted, memory_order_relaxed);
+            state.stats->failures.store(state.failed, memory_order_relaxed);
+            state.stats->deadlineMisses.store(state.missed, memory_order_relaxed);
+            state.stats->queueDepth.store(state.queued, memory_order_relaxed);
         }
+
+        if (transmitClock - state.lastRefresh >= chrono::duration<double>(1.0 / STATS_REFRESH_RATE)) {
+            refreshStats(state, transmitClock);
+        }
+
+        // sleep for dT using a spinLock
+        preciseSleep(sleepTime);
     }
+}
 
-    printf("Transmitted: %i\t Failed: %i\n", transmitted, failed);
-    gpiod_line_set_value(pin, 0);
+// Updates the bit rate and redraws the console, only called STATS_REFRESH_RATE times a second
+// since printing and flushing stdout on every bit disturbs the timing
+void refreshStats(TransmitState &state, chrono::high_resolution_clock::time_point now) {
+    const int sent = state.transmitted + state.failed;
+    const double elapsed = chrono::duration<double>(now - state.lastRefresh).count();
 
-    // Clean Up
-    gpioCleanUp(chip, pin);
+    if (state.stats != nullptr) {
+        state.stats->currentRate.store((sent - state.lastRefreshBits) / elapsed, memory_order_relaxed);
+    }
+    progressBar(state.transmitted, state.failed);
 
-    return logs;
+    state.lastRefresh = now;
+    state.lastRefreshBits = sent;
 }
 
 // Packet Structure:
@@ -322,6 +380,133 @@ transmitMessage(const Configuration &config, const string &message) {
     return transmit(config, generatedTransmission);
 }
 
+/*
+ * Selective repeat ARQ version of transmitMessage
+ * Every packet carries an 8-bit sequence number and up to ARQ_WINDOW packets can be unacknowledged at once.
+ * The receiver reports received/lost bitmaps over the feedback channel and only the lost packets are sent again,
+ * new packets keep going out between retransmissions as long as the window allows it.
+ * Packets that were never acknowledged are resent after two full windows' worth of time.
+ */
+optional<vector<LogEntry>> transmitReliable(const Configuration &config, const string &message) {
+    using namespace std::chrono;
+
+    FeedbackChannel feedback(config.arqPort.value());
+    if (!feedback.isOpen()) {
+        printf("Unable to open the feedback channel on port %i\n", config.arqPort.value());
+        return nullopt;
+    }
+
+    vector<vector<int>> packets = vector<vector<int>>();
+    for (size_t i = 0; i < message.size(); i += PAYLOAD_SIZE) {
+        string payload = message.substr(i, PAYLOAD_SIZE);
+        packets.push_back(Packet(payload, (i / PAYLOAD_SIZE) & 0xFF).getTransmission());
+    }
+
+    if (packets.empty()) {
+        return nullopt;
+    }
+
+    auto logs = vector<LogEntry>();
+
+    struct gpiod_chip *chip = nullptr;
+    struct gpiod_line *pin = nullptr;
+
+    instantiateGPIO(chip, pin);
+
+    gpiod_line_request_output(pin, "transmitter_out", 0);
+
+    const double frequency = config.frequency.value();
+    const auto timeout = duration<double>(frequency * packets.front().size() * ARQ_WINDOW * 2);
+    // The LED is held off for a bit period whenever the window is full
+    const vector<int> idle = {0};
+
+    StatsSegment statsSegment(true);
+    TransmitState state{};
+    state.stats = statsSegment.get();
+    vector<ArqEntry> window(packets.size());
+    deque<size_t> retransmissions = deque<size_t>();
+    size_t base = 0, next = 0;
+    int resent = 0, abandoned = 0;
+
+    while (base < packets.size()) {
+        // Drain the feedback channel
+        while (auto ack = feedback.receive()) {
+            for (int bit = 0; bit < 32; ++bit) {
+                // Map the sequence number back on to the window, anything outside of it is stale
+                auto offset = static_cast<uint8_t>(ack->base + bit - base);
+                if (offset >= ARQ_WINDOW || base + offset >= next) {
+                    continue;
+                }
+
+                ArqEntry &entry = window[base + offset];
+                if ((ack->received >> bit) & 0x01) {
+                    entry.acked = true;
+                } else if (((ack->lost >> bit) & 0x01) && !entry.acked && !entry.queued) {
+                    entry.queued = true;
+                    retransmissions.push_back(base + offset);
+                }
+            }
+        }
+
+        while (base < next && window[base].acked) {
+            ++base;
+        }
+        if (base == packets.size()) {
+            break;
+        }
+
+        const auto now = high_resolution_clock::now();
+        for (size_t i = base; i < next; ++i) {
+            if (!window[i].acked && !window[i].queued && now - window[i].lastSent > timeout) {
+                window[i].queued = true;
+                retransmissions.push_back(i);
+            }
+        }
+
+        optional<size_t> current = nullopt;
+        if (!retransmissions.empty()) {
+            current = retransmissions.front();
+            retransmissions.pop_front();
+            window[current.value()].queued = false;
+            if (window[current.value()].acked) {
+                continue;
+            }
+            ++resent;
+        } else if (next < packets.size() && next < base + ARQ_WINDOW) {
+            current = next++;
+        }
+
+        if (!current.has_value()) {
+            transmitBits(pin, idle, frequency, state, logs);
+            continue;
+        }
+
+        ArqEntry &entry = window[current.value()];
+        if (entry.sends == ARQ_MAX_SENDS) {
+            // Give up on the packet so the window can move on
+            entry.acked = true;
+            ++abandoned;
+            logs.push_back(LogEntry{high_resolution_clock::now() - state.t_0, nullopt,
+                                    "Packet " + to_string(current.value()) + " abandoned"});
+            continue;
+        }
+
+        entry.sends += 1;
+        entry.lastSent = now;
+        state.queued = (packets.size() - next + retransmissions.size() + 1) * packets.front().size();
+        transmitBits(pin, packets[current.value()], frequency, state, logs);
+    }
+
+    printf("Transmitted: %i\t Failed: %i\n", state.transmitted, state.failed);
+    printf("Packets: %zu\t Retransmitted: %i\t Abandoned: %i\n", packets.size(), resent, abandoned);
+    gpiod_line_set_value(pin, 0);
+
+    // Clean Up
+    gpioCleanUp(chip, pin);
+
+    return logs;
+}
+
 /*
  * Uses a combination of thread_sleep (longer time intervals)
  * and spinlocks to get as accurate of a sleep time as we can get without overloading the CPU
@@ -373,7 +558,13 @@ void generateCSV(const vector<LogEntry> &logs, const Configuration &config) {
 
     // frameAverage is of type double[4], we need to destructure it
     for (const LogEntry &entry: logs) {
-        csvStream << entry.deltaTime->count() << "," << entry.transmittedBit.value();
+        // Dropped bits and abandoned packets have no bit
+        csvStream << entry.deltaTime->count() << ",";
+        if (entry.transmittedBit.has_value()) {
+            csvStream << entry.transmittedBit.value();
+        } else {
+            csvStream << "N/A";
+        }
         if (entry.message.has_value()) {
             csvStream << "," << entry.message.value() << "\n";
         } else {
@@ -391,12 +582,18 @@ void showUsage() {
     printf("-f or --frequency\t: Define the frequency of the transmission\n");
     printf("-c or --cycles\t: Define the number of times the transmission is to be repeated\n");
     printf("-o or --output\t: Set the name of the logs\n");
+    printf("-a or --arq\t: Send the message with selective repeat ARQ, listening for feedback on the given UDP port\n");
 }
 
 void signalHandler(int signal) {
-    // TODO: Create the Signal Handler and finish the code for that
-    // Usually just gpio cleanup and such
+    // TODO: Release the GPIO line, the LED is left in whatever state it was interrupted in
+
+    // Don't leave the statistics segment behind for transmitter_stat to find
+    StatsSegment::unlink();
 
+    // Let the default action end the process with the signal
+    std::signal(signal, SIG_DFL);
+    raise(signal);
 }
 
 // Helper functions
@@ -18,6 +18,9 @@
 #include <csignal>
 #include <fstream>
 #include <sstream>
+#include <deque>
+
+#include "StatsSegment.h"
 
 // Change this to move the gpio pin
 // reference: https://www.jetsonhacks.com/nvidia-jetson-nano-2gb-j6-gpio-header-pinout/
@@ -26,6 +29,14 @@
 // sudo gpiofind "<name_of_pin>"
 #define OUT 79
 
+// Selective repeat ARQ tuning
+// The window has to stay below half the 8-bit sequence space
+#define ARQ_WINDOW 32
+#define ARQ_MAX_SENDS 8
+
+// How many times a second the console and the shared memory rate are refreshed
+#define STATS_REFRESH_RATE 10
+
 using namespace std;
 
 // Define enums for standardisation
@@ -57,6 +68,7 @@ struct Configuration {
     optional<double> frequency = 25;
     optional<int> cycles = 1;
     optional<string> output{};
+    optional<int> arqPort{};
 };
 
 struct LogEntry {
@@ -65,4 +77,26 @@ struct LogEntry {
     optional<string> message{};
 };
 
+// Running counters of a transmission so they can be carried across packets
+struct TransmitState {
+    int transmitted = 0;
+    int failed = 0;
+    int missed = 0;
+    // Bits left in the current transmission
+    uint64_t queued = 0;
+    chrono::high_resolution_clock::time_point t_0 = chrono::high_resolution_clock::now();
+    chrono::high_resolution_clock::time_point lastRefresh = t_0;
+    int lastRefreshBits = 0;
+    // Shared memory counters, nullptr if the segment couldn't be created
+    TransmitterStats *stats = nullptr;
+};
+
+// Book-keeping for a single packet in the ARQ window
+struct ArqEntry {
+    bool acked = false;
+    bool queued = false;
+    int sends = 0;
+    chrono::high_resolution_clock::time_point lastSent{};
+};
+
 #endif //TRANSMITTER_MAIN_H
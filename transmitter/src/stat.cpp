@@ -0,0 +1,62 @@
+/*
+ * Reads the live counters the transmitter publishes in shared memory
+ * Usage: ./transmitter_stat [-w]
+ *  -w or --watch keeps printing once a second until the transmitter exits
+ */
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+
+#include "StatsSegment.h"
+
+using namespace std;
+
+// Whether the transmitter that published the statistics still exists, it may have been killed before it could
+// clean up after itself
+bool transmitterAlive(const TransmitterStats &stats) {
+    const pid_t pid = stats.pid.load(memory_order_relaxed);
+    return pid != 0 && (kill(pid, 0) == 0 || errno != ESRCH);
+}
+
+void printStats(const TransmitterStats &stats) {
+    printf("pid: %i\tbits sent: %lu\tfailures: %lu\trate: %.1f bps\tdeadline misses: %lu\tqueue depth: %lu\n",
+           stats.pid.load(memory_order_relaxed),
+           (unsigned long) stats.bitsSent.load(memory_order_relaxed),
+           (unsigned long) stats.failures.load(memory_order_relaxed),
+           stats.currentRate.load(memory_order_relaxed),
+           (unsigned long) stats.deadlineMisses.load(memory_order_relaxed),
+           (unsigned long) stats.queueDepth.load(memory_order_relaxed));
+}
+
+int main(int argc, char *argv[]) {
+    bool watch = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if ((arg == "-w") || (arg == "--watch")) {
+            watch = true;
+        } else {
+            printf("./transmitter_stat [-w]\n");
+            printf("-w or --watch\t: Keep printing the statistics once a second\n");
+            return 0;
+        }
+    }
+
+    StatsSegment segment(false);
+    const TransmitterStats *stats = segment.get();
+    if (stats == nullptr || !transmitterAlive(*stats)) {
+        printf("No transmitter is running\n");
+        return -1;
+    }
+
+    printStats(*stats);
+    while (watch && transmitterAlive(*stats)) {
+        this_thread::sleep_for(chrono::seconds(1));
+        printStats(*stats);
+    }
+
+    return 0;
+}